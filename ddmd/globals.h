@@ -232,6 +232,7 @@ struct Param
     uint32_t dwarfVersion;
 
     uint32_t hashThreshold; // MD5 hash symbols larger than this threshold (0 = no hashing)
+    bool mangleBackrefs; // use back references for repeated identifiers and types in mangled names
 
     bool outputSourceLocations; // if true, output line tables.
 #endif
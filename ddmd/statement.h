@@ -67,6 +67,9 @@ struct code;
 
 bool inferAggregate(ForeachStatement *fes, Scope *sc, Dsymbol *&sapply);
 bool inferApplyArgTypes(ForeachStatement *fes, Scope *sc, Dsymbol *&sapply);
+#if IN_LLVM
+int statementBlockExit(Statement *s, FuncDeclaration *func, bool mustNotThrow);
+#endif
 
 /* How a statement exits; this is returned by blockExit()
  */
@@ -264,6 +267,9 @@ public:
     Statement *_body;
     Expression *condition;
     Loc endloc;                 // location of ';' after while
+#if IN_LLVM
+    Expressions *loopHints;     // arguments of pragma(LDC_loop, ...)
+#endif
 
     Statement *syntaxCopy();
     bool hasBreak();
@@ -286,6 +292,10 @@ public:
     // treat that label as referring to this loop.
     Statement *relatedLabeled;
 
+#if IN_LLVM
+    Expressions *loopHints;     // arguments of pragma(LDC_loop, ...)
+#endif
+
     Statement *syntaxCopy();
     Statement *scopeCode(Scope *sc, Statement **sentry, Statement **sexit, Statement **sfinally);
     Statement *getRelatedLabeled() { return relatedLabeled ? relatedLabeled : this; }
@@ -33,7 +33,9 @@
 #include "driver/cache_pruning.h"
 #include "driver/cl_options.h"
 #include "driver/cl_options_sanitizers.h"
+#include "driver/toobj.h"
 #include "driver/ldc-version.h"
+#include "gen/irstate.h"
 #include "gen/logger.h"
 #include "gen/optimizer.h"
 
@@ -48,6 +50,7 @@
 #include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
 
 // Include close() declaration.
 #if !defined(_MSC_VER) && !defined(__MINGW32__)
@@ -207,10 +210,11 @@ public:
 };
 
 void storeCacheFileName(llvm::StringRef cacheObjectHash,
-                        llvm::SmallString<128> &filePath) {
+                        llvm::SmallString<128> &filePath,
+                        const char *ext = global.obj_ext) {
   filePath = opts::cacheDir;
   llvm::sys::path::append(filePath, llvm::Twine("ircache_") + cacheObjectHash +
-                                        "." + global.obj_ext);
+                                        "." + ext);
 }
 
 // Output to `hash_os` all commandline flags, and try to skip the ones that have
@@ -322,67 +326,13 @@ void outputIR2ObjRelevantEnvironmentOpts(llvm::raw_ostream &hash_os) {
   // There are no relevant environment options at the moment.
 }
 
-} // anonymous namespace
-
-namespace cache {
-
-void calculateModuleHash(llvm::Module *m, llvm::SmallString<32> &str) {
-  raw_hash_ostream hash_os;
-
-  // Let hash depend on the compiler version:
-  hash_os << global.ldc_version << global.version << global.llvm_version
-          << ldc::built_with_Dcompiler_version;
-
-  // Let hash depend on compile flags that change the outputted obj file,
-  // but whose changes are not always observable in the pre-optimized IR used
-  // for hashing:
-  outputIR2ObjRelevantCmdlineArgs(hash_os);
-  outputIR2ObjRelevantEnvironmentOpts(hash_os);
-
-  llvm::WriteBitcodeToFile(m, hash_os);
-  hash_os.resultAsString(str);
-  IF_LOG Logger::println("Module's LLVM bitcode hash is: %s", str.c_str());
-}
-
-std::string cacheLookup(llvm::StringRef cacheObjectHash) {
-  if (opts::cacheDir.empty())
-    return "";
-
-  if (!llvm::sys::fs::exists(opts::cacheDir)) {
-    IF_LOG Logger::println("Cache directory does not exist, no object found.");
-    return "";
-  }
-
-  llvm::SmallString<128> filePath;
-  storeCacheFileName(cacheObjectHash, filePath);
-  if (llvm::sys::fs::exists(filePath.c_str())) {
-    IF_LOG Logger::println("Cache object found! %s", filePath.c_str());
-    return filePath.str().str();
-  }
-
-  IF_LOG Logger::println("Cache object not found.");
-  return "";
-}
-
-void cacheObjectFile(llvm::StringRef objectFile,
-                     llvm::StringRef cacheObjectHash) {
-  if (opts::cacheDir.empty())
-    return;
-
-  if (!llvm::sys::fs::exists(opts::cacheDir) &&
-      llvm::sys::fs::create_directories(opts::cacheDir)) {
-    error(Loc(), "Unable to create cache directory: %s",
-          opts::cacheDir.c_str());
-    fatal();
-  }
-
+// Adds `file` to the cache as `cacheFile`.
+void addFileToCache(llvm::StringRef file,
+                    const llvm::SmallString<128> &cacheFile) {
   // To prevent bad cache files, add files to the cache atomically: first copy
   // to a temporary file and then rename that temp file to the cache entry
   // filename (rename is atomic).
 
-  llvm::SmallString<128> cacheFile;
-  storeCacheFileName(cacheObjectHash, cacheFile);
-
   llvm::SmallString<128> tempFile;
   if (llvm::sys::fs::createUniqueFile(llvm::Twine(cacheFile) + ".tmp%%%%%%%",
                                       tempFile)) {
@@ -390,11 +340,11 @@ void cacheObjectFile(llvm::StringRef objectFile,
     fatal();
   }
 
-  IF_LOG Logger::println("Copy object file to temp file: %s to %s",
-                         objectFile.str().c_str(), tempFile.c_str());
-  if (llvm::sys::fs::copy_file(objectFile, tempFile.c_str())) {
-    error(Loc(), "Failed to copy object file to cache: %s to %s",
-          objectFile.str().c_str(), tempFile.c_str());
+  IF_LOG Logger::println("Copy file to temp file: %s to %s",
+                         file.str().c_str(), tempFile.c_str());
+  if (llvm::sys::fs::copy_file(file, tempFile.c_str())) {
+    error(Loc(), "Failed to copy file to cache: %s to %s", file.str().c_str(),
+          tempFile.c_str());
     fatal();
   }
   IF_LOG Logger::println("Rename temp file to cache file: %s to %s",
@@ -406,49 +356,47 @@ void cacheObjectFile(llvm::StringRef objectFile,
   }
 }
 
-void recoverObjectFile(llvm::StringRef cacheObjectHash,
-                       llvm::StringRef objectFile) {
-  llvm::SmallString<128> cacheFile;
-  storeCacheFileName(cacheObjectHash, cacheFile);
-
+// Recovers the output file `file` from the cached `cacheFile`.
+void recoverFile(const llvm::SmallString<128> &cacheFile,
+                 llvm::StringRef file) {
   // Remove the potentially pre-existing output file.
-  llvm::sys::fs::remove(objectFile);
+  llvm::sys::fs::remove(file);
 
   switch (cacheRecoveryMode) {
   case RetrievalMode::Copy: {
-    IF_LOG Logger::println("Copy cached object file: %s -> %s",
-                           cacheFile.c_str(), objectFile.str().c_str());
-    if (llvm::sys::fs::copy_file(cacheFile.c_str(), objectFile)) {
+    IF_LOG Logger::println("Copy cached file: %s -> %s", cacheFile.c_str(),
+                           file.str().c_str());
+    if (llvm::sys::fs::copy_file(cacheFile.c_str(), file)) {
       error(Loc(), "Failed to copy the cached file: %s -> %s",
-            cacheFile.c_str(), objectFile.str().c_str());
+            cacheFile.c_str(), file.str().c_str());
       fatal();
     }
   } break;
   case RetrievalMode::HardLink: {
-    IF_LOG Logger::println("HardLink output to cached object file: %s -> %s",
-                           objectFile.str().c_str(), cacheFile.c_str());
-    if (createHardLink(cacheFile.c_str(), objectFile.str().c_str())) {
+    IF_LOG Logger::println("HardLink output to cached file: %s -> %s",
+                           file.str().c_str(), cacheFile.c_str());
+    if (createHardLink(cacheFile.c_str(), file.str().c_str())) {
       error(Loc(), "Failed to create a hard link to the cached file: %s -> %s",
-            cacheFile.c_str(), objectFile.str().c_str());
+            cacheFile.c_str(), file.str().c_str());
       fatal();
     }
   } break;
   case RetrievalMode::AnyLink: {
-    IF_LOG Logger::println("Link output to cached object file: %s -> %s",
-                           objectFile.str().c_str(), cacheFile.c_str());
-    if (llvm::sys::fs::create_link(cacheFile.c_str(), objectFile)) {
+    IF_LOG Logger::println("Link output to cached file: %s -> %s",
+                           file.str().c_str(), cacheFile.c_str());
+    if (llvm::sys::fs::create_link(cacheFile.c_str(), file)) {
       error(Loc(), "Failed to create a link to the cached file: %s -> %s",
-            cacheFile.c_str(), objectFile.str().c_str());
+            cacheFile.c_str(), file.str().c_str());
       fatal();
     }
   } break;
   case RetrievalMode::SymLink: {
-    IF_LOG Logger::println("SymLink output to cached object file: %s -> %s",
-                           objectFile.str().c_str(), cacheFile.c_str());
-    if (createSymLink(cacheFile.c_str(), objectFile.str().c_str())) {
+    IF_LOG Logger::println("SymLink output to cached file: %s -> %s",
+                           file.str().c_str(), cacheFile.c_str());
+    if (createSymLink(cacheFile.c_str(), file.str().c_str())) {
       error(Loc(),
             "Failed to create a symbolic link to the cached file: %s -> %s",
-            cacheFile.c_str(), objectFile.str().c_str());
+            cacheFile.c_str(), file.str().c_str());
       fatal();
     }
   } break;
@@ -478,6 +426,102 @@ void recoverObjectFile(llvm::StringRef cacheObjectHash,
   }
 }
 
+} // anonymous namespace
+
+namespace cache {
+
+void calculateModuleHash(llvm::Module *m, llvm::SmallString<32> &str) {
+  raw_hash_ostream hash_os;
+
+  // Let hash depend on the compiler version:
+  hash_os << global.ldc_version << global.version << global.llvm_version
+          << ldc::built_with_Dcompiler_version;
+
+  // Let hash depend on compile flags that change the outputted obj file,
+  // but whose changes are not always observable in the pre-optimized IR used
+  // for hashing:
+  outputIR2ObjRelevantCmdlineArgs(hash_os);
+  outputIR2ObjRelevantEnvironmentOpts(hash_os);
+
+  // Let hash depend on the target machine the module is emitted for. The
+  // cmdline args are the same for all DCompute targets of one invocation, so
+  // e.g. the PTX for sm_35 and sm_50 must not share a cache entry.
+  if (gTargetMachine) {
+    hash_os << gTargetMachine->getTargetTriple().str()
+            << gTargetMachine->getTargetCPU()
+            << gTargetMachine->getTargetFeatureString();
+  }
+
+  llvm::WriteBitcodeToFile(m, hash_os);
+  hash_os.resultAsString(str);
+  IF_LOG Logger::println("Module's LLVM bitcode hash is: %s", str.c_str());
+}
+
+std::string cacheLookup(llvm::StringRef cacheObjectHash) {
+  if (opts::cacheDir.empty())
+    return "";
+
+  if (!llvm::sys::fs::exists(opts::cacheDir)) {
+    IF_LOG Logger::println("Cache directory does not exist, no object found.");
+    return "";
+  }
+
+  llvm::SmallString<128> filePath;
+  storeCacheFileName(cacheObjectHash, filePath);
+  if (llvm::sys::fs::exists(filePath.c_str())) {
+    // With -gsplit-dwarf, the .dwo file is part of the cache entry.
+    llvm::SmallString<128> dwoFilePath;
+    storeCacheFileName(cacheObjectHash, dwoFilePath, "dwo");
+    if (opts::splitDwarf && !llvm::sys::fs::exists(dwoFilePath.c_str())) {
+      IF_LOG Logger::println("Cache object found, but its .dwo file is not.");
+      return "";
+    }
+
+    IF_LOG Logger::println("Cache object found! %s", filePath.c_str());
+    return filePath.str().str();
+  }
+
+  IF_LOG Logger::println("Cache object not found.");
+  return "";
+}
+
+void cacheObjectFile(llvm::StringRef objectFile,
+                     llvm::StringRef cacheObjectHash) {
+  if (opts::cacheDir.empty())
+    return;
+
+  if (!llvm::sys::fs::exists(opts::cacheDir) &&
+      llvm::sys::fs::create_directories(opts::cacheDir)) {
+    error(Loc(), "Unable to create cache directory: %s",
+          opts::cacheDir.c_str());
+    fatal();
+  }
+
+  // Add the .dwo file first, so that the entry is complete as soon as the
+  // object file shows up in the cache.
+  if (opts::splitDwarf) {
+    llvm::SmallString<128> cacheFile;
+    storeCacheFileName(cacheObjectHash, cacheFile, "dwo");
+    addFileToCache(getSplitDwarfFileName(objectFile), cacheFile);
+  }
+
+  llvm::SmallString<128> cacheFile;
+  storeCacheFileName(cacheObjectHash, cacheFile);
+  addFileToCache(objectFile, cacheFile);
+}
+
+void recoverObjectFile(llvm::StringRef cacheObjectHash,
+                       llvm::StringRef objectFile) {
+  llvm::SmallString<128> cacheFile;
+  storeCacheFileName(cacheObjectHash, cacheFile);
+  recoverFile(cacheFile, objectFile);
+
+  if (opts::splitDwarf) {
+    storeCacheFileName(cacheObjectHash, cacheFile, "dwo");
+    recoverFile(cacheFile, getSplitDwarfFileName(objectFile));
+  }
+}
+
 void pruneCache() {
   if (!opts::cacheDir.empty() && isPruningEnabled()) {
     ::pruneCache(opts::cacheDir.data(), opts::cacheDir.size(), pruneInterval,
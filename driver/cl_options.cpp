@@ -21,10 +21,13 @@ namespace opts {
 // This vector is filled by parseCommandLine in main.cpp.
 llvm::SmallVector<const char *, 32> allArguments;
 
+CoverageIncrement coverageIncrement = CoverageIncrement::atomic;
+
 /* Option parser that defaults to zero when no explicit number is given.
  * i.e.:  -cov    --> value = 0
  *        -cov=9  --> value = 9
  *        -cov=101 --> error, value must be in range [0..100]
+ *        -cov=fast/hit --> counter increment kind, keeps the percentage
  */
 struct CoverageParser : public cl::parser<unsigned char> {
   explicit CoverageParser(cl::Option &O) : cl::parser<unsigned char>(O) {}
@@ -36,6 +39,13 @@ struct CoverageParser : public cl::parser<unsigned char> {
       return false;
     }
 
+    if (Arg == "fast" || Arg == "hit") {
+      coverageIncrement = Arg == "fast" ? CoverageIncrement::nonAtomic
+                                        : CoverageIncrement::boolean;
+      Val = global.params.covPercent <= 100 ? global.params.covPercent : 0;
+      return false;
+    }
+
     if (Arg.getAsInteger(0, Val)) {
       return O.error("'" + Arg +
                      "' value invalid for required coverage percentage");
@@ -134,6 +144,24 @@ static cl::opt<ubyte, true> debugInfo(
         clEnumValN(3, "gline-tables-only", "Add line tables only")),
     cl::location(global.params.symdebug), cl::init(0));
 
+cl::opt<bool> splitDwarf(
+    "gsplit-dwarf", cl::ZeroOrMore,
+    cl::desc("Write the debug info into a separate .dwo file next to each "
+             "object file, leaving only a skeleton for the linker (ELF "
+             "only, implies -g)"));
+
+cl::opt<std::string> compressDebugSections(
+    "gz", cl::ZeroOrMore, cl::ValueOptional,
+    cl::value_desc("none|zlib|zlib-gnu"),
+    cl::desc("Compress the debug sections of object files (zlib if no format "
+             "is given)"));
+
+cl::opt<bool> limitDebugInfo(
+    "flimit-debug-info", cl::ZeroOrMore,
+    cl::desc("Only declare aggregate types defined in other modules in the "
+             "debug info, relying on them being described by the debug info "
+             "of their own module"));
+
 cl::opt<bool> noAsm("noasm", cl::desc("Disallow use of inline assembler"),
                     cl::ZeroOrMore);
 
@@ -353,10 +381,21 @@ cl::opt<bool, true>
     singleObj("singleobj", cl::desc("Create only a single output object file"),
               cl::ZeroOrMore, cl::location(global.params.oneobj));
 
+cl::opt<bool> precomputeCtorOrder(
+    "precompute-ctor-order", cl::ZeroOrMore,
+    cl::desc("With -singleobj, sort the module constructors at compile time "
+             "and emit the order for the runtime (_d_moduleCtorOrder)"));
+
 cl::opt<uint32_t, true> hashThreshold(
     "hash-threshold", cl::ZeroOrMore, cl::location(global.params.hashThreshold),
     cl::desc("Hash symbol names longer than this threshold (experimental)"));
 
+static cl::opt<bool, true> mangleBackrefs(
+    "mangle-backrefs", cl::ZeroOrMore,
+    cl::location(global.params.mangleBackrefs),
+    cl::desc("Compress mangled names by referencing repeated identifiers and "
+             "types (requires druntime/Phobos built with the same setting)"));
+
 cl::opt<bool> linkonceTemplates(
     "linkonce-templates", cl::ZeroOrMore,
     cl::desc(
@@ -366,6 +405,12 @@ cl::opt<bool> disableLinkerStripDead(
     "disable-linker-strip-dead", cl::ZeroOrMore,
     cl::desc("Do not try to remove unused symbols during linking"));
 
+cl::opt<bool> foldIdenticalCode(
+    "fold-identical-code", cl::ZeroOrMore,
+    cl::desc("Mark template instances as unnamed_addr, merge identical "
+             "functions and let the linker fold identical code sections "
+             "(safe ICF, requires -linker=gold)"));
+
 // Math options
 bool fFastMath; // Storage for the dynamically created ffast-math option.
 llvm::FastMathFlags defaultFMF;
@@ -401,7 +446,8 @@ cl::opt<bool, true> betterC(
 cl::opt<unsigned char, true, CoverageParser> coverageAnalysis(
     "cov", cl::ZeroOrMore, cl::location(global.params.covPercent),
     cl::desc("Compile-in code coverage analysis\n(use -cov=n for n% "
-             "minimum required coverage)"),
+             "minimum required coverage, -cov=fast for non-atomic counters, "
+             "-cov=hit to only record whether a line was executed)"),
     cl::ValueOptional, cl::init(127));
 
 #if LDC_WITH_PGO
@@ -416,7 +462,46 @@ cl::opt<std::string> usefileInstrProf(
     "fprofile-instr-use", cl::ZeroOrMore, cl::value_desc("filename"),
     cl::desc("Use instrumentation data for profile-guided optimization"),
     cl::ValueRequired);
+
+cl::opt<std::string> symbolOrderingFile(
+    "symbol-ordering-file", cl::ZeroOrMore, cl::value_desc("filename"),
+    cl::desc("Write the functions profiled by -fprofile-instr-use to "
+             "<filename>, hottest first, and pass it to the linker "
+             "(-linker=gold or -linker=lld)"));
+
+#if LDC_LLVM_VER >= 309
+cl::opt<std::string> genfileIRProf(
+    "fprofile-generate", cl::value_desc("directory"),
+    cl::desc("Generate code instrumented by LLVM's IR-level PGO passes, "
+             "writing the profile to default.profraw (or "
+             "'<directory>/default_%m.profraw' when given)"),
+    cl::ZeroOrMore, cl::ValueOptional);
+
+cl::opt<std::string> usefileIRProf(
+    "fprofile-use", cl::ZeroOrMore, cl::value_desc("filename"),
+    cl::desc("Use IR-level instrumentation data for profile-guided "
+             "optimization"),
+    cl::ValueRequired);
+
+cl::opt<bool> coverageMapping(
+    "fcoverage-mapping", cl::ZeroOrMore,
+    cl::desc("Generate coverage mapping for source-based code coverage "
+             "(llvm-cov), using the -fprofile-instr-generate counters"));
 #endif
+#if LDC_LLVM_VER >= 400
+cl::opt<bool> continuousProfile(
+    "fprofile-continuous", cl::ZeroOrMore,
+    cl::desc("Map the profile counters onto the profile file at program "
+             "startup, so that the profile is kept up to date without an "
+             "exit-time dump (POSIX only)"));
+#endif
+#endif
+
+cl::opt<std::string> usefileSampleProf(
+    "fprofile-sample-use", cl::ZeroOrMore, cl::value_desc("filename"),
+    cl::desc("Use sample profile data (e.g. converted from perf) for "
+             "profile-guided optimization; implies -gline-tables-only"),
+    cl::ValueRequired);
 
 cl::opt<bool>
     instrumentFunctions("finstrument-functions", cl::ZeroOrMore,
@@ -454,6 +539,12 @@ cl::opt<std::string>
                        cl::desc("Prefix to prepend to the generated kernel files."),
                        cl::init("kernels"),
                        cl::value_desc("prefix"));
+cl::opt<unsigned>
+    dcomputeJobs("mdcompute-jobs",
+                 cl::desc("Maximum number of DCompute targets to optimize and "
+                          "emit in parallel (default: number of hardware "
+                          "threads)"),
+                 cl::init(0), cl::value_desc("N"));
 #endif
 
 static cl::extrahelp footer(
@@ -48,6 +48,9 @@ extern cl::list<std::string> runargs;
 extern cl::opt<bool> invokedByLDMD;
 extern cl::opt<bool> compileOnly;
 extern cl::opt<bool> useDIP1000;
+extern cl::opt<bool> splitDwarf;
+extern cl::opt<std::string> compressDebugSections;
+extern cl::opt<bool> limitDebugInfo;
 extern cl::opt<bool> noAsm;
 extern cl::opt<bool> dontWriteObj;
 extern cl::opt<std::string> objectFile;
@@ -75,8 +78,10 @@ extern cl::opt<bool> m64bits;
 extern cl::opt<std::string> mTargetTriple;
 extern cl::opt<std::string> mABI;
 extern FloatABI::Type floatABI;
+extern cl::opt<bool> precomputeCtorOrder;
 extern cl::opt<bool> linkonceTemplates;
 extern cl::opt<bool> disableLinkerStripDead;
+extern cl::opt<bool> foldIdenticalCode;
 
 // Math options
 extern bool fFastMath;
@@ -89,9 +94,36 @@ extern bool nonSafeBoundsChecks;
 #if LDC_WITH_PGO
 extern cl::opt<std::string> genfileInstrProf;
 extern cl::opt<std::string> usefileInstrProf;
+extern cl::opt<std::string> symbolOrderingFile;
+#if LDC_LLVM_VER >= 309
+extern cl::opt<std::string> genfileIRProf;
+extern cl::opt<std::string> usefileIRProf;
+extern cl::opt<bool> coverageMapping;
+#endif
+#if LDC_LLVM_VER >= 400
+extern cl::opt<bool> continuousProfile;
 #endif
+#endif
+#if LDC_WITH_PGO && LDC_LLVM_VER >= 309
+inline bool isGeneratingIRProf() {
+  return genfileIRProf.getNumOccurrences() > 0;
+}
+inline bool isUsingIRProf() { return !usefileIRProf.empty(); }
+#else
+inline bool isGeneratingIRProf() { return false; }
+inline bool isUsingIRProf() { return false; }
+#endif
+extern cl::opt<std::string> usefileSampleProf;
 extern cl::opt<bool> instrumentFunctions;
 
+// How the -cov line counters are incremented
+enum class CoverageIncrement {
+  atomic,    // atomic increment (default)
+  nonAtomic, // -cov=fast: plain load/add/store
+  boolean,   // -cov=hit: only set to 1 if still 0
+};
+extern CoverageIncrement coverageIncrement;
+
 // Arguments to -d-debug
 extern std::vector<std::string> debugArgs;
 // Arguments to -run
@@ -120,6 +152,7 @@ extern cl::opt<std::string> saveOptimizationRecord;
 #if LDC_LLVM_SUPPORTED_TARGET_SPIRV || LDC_LLVM_SUPPORTED_TARGET_NVPTX
 extern cl::list<std::string> dcomputeTargets;
 extern cl::opt<std::string> dcomputeFilePrefix;
+extern cl::opt<unsigned> dcomputeJobs;
 #endif
 }
 #endif
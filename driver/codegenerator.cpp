@@ -17,8 +17,11 @@
 #include "driver/linker.h"
 #include "driver/toobj.h"
 #include "gen/logger.h"
+#include "gen/moduleinfo.h"
 #include "gen/modules.h"
+#include "gen/pgo.h"
 #include "gen/runtime.h"
+#include "gen/uda.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
@@ -66,8 +69,9 @@ createAndSetDiagnosticsOutputFile(IRState &irs, llvm::LLVMContext &ctx,
     ctx.setDiagnosticsOutputFile(
         llvm::make_unique<llvm::yaml::Output>(diagnosticsOutputFile->os()));
 
-    // If there is instrumentation data available, also output function hotness
-    if (!global.params.genInstrProf && global.params.datafileInstrProf) {
+    // If there is profile data available, also output function hotness
+    if ((!global.params.genInstrProf && global.params.datafileInstrProf) ||
+        opts::isUsingIRProf() || !opts::usefileSampleProf.empty()) {
 #if LDC_LLVM_VER >= 500
       ctx.setDiagnosticsHotnessRequested(true);
 #else
@@ -200,6 +204,12 @@ CodeGenerator::~CodeGenerator() {
     insertBitcodeFiles(ir_->module, ir_->context(),
                        *global.params.bitcodeFiles);
 
+    // Only the object defining D main gets the table, so that there is a
+    // single one per program.
+    if (opts::precomputeCtorOrder && rootHasMain) {
+      emitModuleCtorOrder(ir_);
+    }
+
     writeAndFreeLLModule(filename);
   }
 }
@@ -249,12 +259,21 @@ void CodeGenerator::finishLLModule(Module *m) {
 void CodeGenerator::writeAndFreeLLModule(const char *filename) {
   ir_->objc.finalize();
 
+  applyTargetClonesUDAs(*ir_);
+
   // Issue #1829: make sure all replaced global variables are replaced
   // everywhere.
   ir_->replaceGlobals();
 
   ir_->DBuilder.Finalize();
 
+#if LDC_WITH_PGO && LDC_LLVM_VER >= 309
+  // Once per LLVM module, which may comprise several D modules (-singleobj).
+  if (ir_->CoverageMapping) {
+    ir_->CoverageMapping->emit(*ir_);
+  }
+#endif
+
   emitLLVMUsedArray(*ir_);
   emitLinkerOptions(*ir_, ir_->module, ir_->context());
 
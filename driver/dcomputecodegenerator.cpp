@@ -9,13 +9,30 @@
 
 #include "driver/dcomputecodegenerator.h"
 #include "driver/cl_options.h"
+#include "driver/toobj.h"
 #include "ddmd/errors.h"
 #include "gen/cl_helpers.h"
+#include "gen/logger.h"
 #include "ir/irdsymbol.h"
+#if LDC_LLVM_VER >= 400
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#else
+#include "llvm/Bitcode/ReaderWriter.h"
+#endif
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
 #include <array>
+#include <atomic>
 #include <string>
 #include <algorithm>
+#include <thread>
+#include <vector>
 
 #if !(LDC_LLVM_SUPPORTED_TARGET_SPIRV || LDC_LLVM_SUPPORTED_TARGET_NVPTX)
 
@@ -87,9 +104,99 @@ void DComputeCodeGenManager::emit(Module *m) {
   }
 }
 
+namespace {
+// A DCompute module serialized to bitcode, so that it can be optimized and
+// emitted independently of the (shared) LLVM context it was generated in.
+struct KernelJob {
+  DComputeTarget *target;
+  std::string path;
+  llvm::SmallVector<char, 0> bitcode;
+};
+
+void writeKernelJob(KernelJob &job) {
+  llvm::LLVMContext context;
+  llvm::MemoryBufferRef buffer(
+      llvm::StringRef(job.bitcode.data(), job.bitcode.size()), job.path);
+
+  auto module = llvm::parseBitcodeFile(buffer, context);
+  if (!module) {
+#if LDC_LLVM_VER >= 400
+    const std::string msg = llvm::toString(module.takeError());
+#else
+    const std::string msg = module.getError().message();
+#endif
+    error(Loc(), "cannot reload DCompute module for '%s': %s",
+          job.path.c_str(), msg.c_str());
+    fatal();
+  }
+
+  // gTargetMachine is thread-local.
+  job.target->setGTargetMachine();
+  ::writeModule(module->get(), job.path.c_str());
+  delete gTargetMachine;
+  gTargetMachine = nullptr;
+}
+}
+
+unsigned DComputeCodeGenManager::getNumJobs() const {
+  // The logger isn't thread-safe, keep -vv output readable.
+  if (!llvm::llvm_is_multithreaded() || Logger::enabled())
+    return 1;
+
+  unsigned n = opts::dcomputeJobs;
+  if (n == 0)
+    n = std::thread::hardware_concurrency();
+  return std::max(1u, std::min(n, static_cast<unsigned>(targets.size())));
+}
+
 void DComputeCodeGenManager::writeModules() {
-  for (auto &target : targets) {
-    target->writeModule();
+  const unsigned numJobs = getNumJobs();
+  if (numJobs == 1) {
+    for (auto &target : targets) {
+      target->writeModule();
+    }
+    return;
+  }
+
+  // The modules all live in the same LLVM context, which must not be used
+  // concurrently. Finalize and serialize them here, each job then reloads its
+  // module into a private context before running the optimizer and backend.
+  std::vector<KernelJob> jobs(targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    auto target = targets[i];
+    auto &job = jobs[i];
+    job.target = target;
+    job.path = target->finalizeModule();
+    {
+      llvm::raw_svector_ostream os(job.bitcode);
+      llvm::WriteBitcodeToFile(&target->_ir->module, os);
+    }
+    delete target->_ir;
+    target->_ir = nullptr;
+  }
+
+  // writeModule() makes the cache path absolute on first use, which must not
+  // race between the jobs.
+  if (!opts::cacheDir.empty()) {
+    llvm::SmallString<128> cacheDir(opts::cacheDir.c_str());
+    llvm::sys::fs::make_absolute(cacheDir);
+    opts::cacheDir = cacheDir.c_str();
+  }
+
+  std::atomic<size_t> nextJob(0);
+  const auto worker = [&jobs, &nextJob]() {
+    for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+      writeKernelJob(jobs[i]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < numJobs; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
   }
 }
 
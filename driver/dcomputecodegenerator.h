@@ -26,6 +26,8 @@ class DComputeCodeGenManager {
   DComputeTarget *createComputeTarget(const std::string &s);
   IRState *oldGIR = nullptr;
   llvm::TargetMachine *oldGTargetMachine = nullptr;
+  // Number of targets to write in parallel, see -mdcompute-jobs.
+  unsigned getNumJobs() const;
 public:
   void emit(Module *m);
   void writeModules();
@@ -54,6 +54,10 @@ private:
 
   virtual void addLinker();
   virtual void addUserSwitches();
+#if LDC_WITH_PGO
+  void addSymbolOrderingFile();
+#endif
+  void addIdenticalCodeFoldingFlags();
   void addDefaultLibs();
   virtual void addTargetFlags();
 
@@ -331,7 +335,7 @@ void ArgsBuilder::build(llvm::StringRef outputPath,
   // Link with profile-rt library when generating an instrumented binary.
   // profile-rt uses Phobos (MD5 hashing) and therefore must be passed on the
   // commandline before Phobos.
-  if (global.params.genInstrProf) {
+  if (global.params.genInstrProf || opts::isGeneratingIRProf()) {
 #if LDC_LLVM_VER >= 308
     if (global.params.targetTriple->isOSLinux()) {
       // For Linux, explicitly define __llvm_profile_runtime as undefined
@@ -342,6 +346,10 @@ void ArgsBuilder::build(llvm::StringRef outputPath,
     args.push_back("-lldc-profile-rt");
   }
 
+#if LDC_WITH_PGO
+  addSymbolOrderingFile();
+#endif
+
   // user libs
   for (auto libfile : *global.params.libfiles) {
     args.push_back(libfile);
@@ -380,9 +388,14 @@ void ArgsBuilder::build(llvm::StringRef outputPath,
     // instrumented binary. The runtime relies on magic sections, which
     // would be stripped by gc-section on older version of ld, see bug:
     // https://sourceware.org/bugzilla/show_bug.cgi?id=19161
-    if (!opts::disableLinkerStripDead && !global.params.genInstrProf) {
+    if (!opts::disableLinkerStripDead && !global.params.genInstrProf &&
+        !opts::isGeneratingIRProf()) {
       addLdFlag("--gc-sections");
     }
+
+    if (opts::foldIdenticalCode) {
+      addIdenticalCodeFoldingFlags();
+    }
   }
 
   addDefaultLibs();
@@ -392,6 +405,46 @@ void ArgsBuilder::build(llvm::StringRef outputPath,
 
 //////////////////////////////////////////////////////////////////////////////
 
+void ArgsBuilder::addIdenticalCodeFoldingFlags() {
+  // Only gold distinguishes functions whose address is taken (safe ICF); lld
+  // would fold all identical sections. Within each object file, identical
+  // functions have already been merged by the optimizer.
+  llvm::StringRef linker = opts::linker;
+  if (linker != "gold") {
+    warning(Loc(), "-fold-identical-code only folds identical code across "
+                   "object files with -linker=gold");
+    return;
+  }
+
+  addLdFlag("--icf=safe");
+  // Report the folded sections.
+  if (global.params.verbose) {
+    addLdFlag("--print-icf-sections");
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+#if LDC_WITH_PGO
+void ArgsBuilder::addSymbolOrderingFile() {
+  if (opts::symbolOrderingFile.empty())
+    return;
+
+  // gold orders (function) sections, lld orders symbols directly.
+  llvm::StringRef linker = opts::linker;
+  if (linker == "gold") {
+    addLdFlag("--section-ordering-file", opts::symbolOrderingFile);
+  } else if (linker.startswith("lld")) {
+    addLdFlag("--symbol-ordering-file", opts::symbolOrderingFile);
+  } else {
+    warning(Loc(), "-symbol-ordering-file is only passed to the linker with "
+                   "-linker=gold or -linker=lld");
+  }
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+
 void ArgsBuilder::addLinker() {
   if (!opts::linker.empty())
     args.push_back("-fuse-ld=" + opts::linker);
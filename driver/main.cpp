@@ -41,6 +41,7 @@
 #include "gen/objcgen.h"
 #include "gen/optimizer.h"
 #include "gen/passes/Passes.h"
+#include "gen/pgo.h"
 #include "gen/runtime.h"
 #include "gen/uda.h"
 #include "gen/abi.h"
@@ -438,7 +439,14 @@ void parseCommandLine(int argc, char **argv, Strings &sourceFiles,
 
 // PGO options
 #if LDC_WITH_PGO
-  if (genfileInstrProf.getNumOccurrences() > 0) {
+#if LDC_LLVM_VER >= 309
+  // The coverage mapping refers to the PGO region counters.
+  const bool genInstrProf =
+      genfileInstrProf.getNumOccurrences() > 0 || coverageMapping;
+#else
+  const bool genInstrProf = genfileInstrProf.getNumOccurrences() > 0;
+#endif
+  if (genInstrProf) {
     global.params.genInstrProf = true;
     if (genfileInstrProf.empty()) {
 #if LDC_LLVM_VER >= 309
@@ -456,7 +464,32 @@ void parseCommandLine(int argc, char **argv, Strings &sourceFiles,
     // profdata file:
     initFromPathString(global.params.datafileInstrProf, usefileInstrProf);
   }
+
+  if ((isGeneratingIRProf() || isUsingIRProf()) &&
+      (global.params.genInstrProf || global.params.datafileInstrProf)) {
+    error(Loc(), "IR-level PGO (-fprofile-generate/-fprofile-use) cannot be "
+                 "combined with -fprofile-instr-generate/-fprofile-instr-use");
+  }
+  if (isGeneratingIRProf() && isUsingIRProf()) {
+    error(Loc(), "-fprofile-generate cannot be combined with -fprofile-use");
+  }
+#if LDC_LLVM_VER >= 400
+  if (continuousProfile && !global.params.genInstrProf &&
+      !isGeneratingIRProf()) {
+    error(Loc(), "-fprofile-continuous requires -fprofile-instr-generate or "
+                 "-fprofile-generate");
+  }
 #endif
+#endif
+
+  // Sample profiles are attributed to source lines, so we need line tables.
+  if (!usefileSampleProf.empty() && global.params.symdebug == 0) {
+    global.params.symdebug = 3;
+  }
+
+  if (splitDwarf && global.params.symdebug == 0) {
+    global.params.symdebug = 1;
+  }
 
   initializeSanitizerOptionsFromCmdline();
 
@@ -946,6 +979,19 @@ void registerPredefinedVersions() {
 #undef STR
 }
 
+/// Makes LLVM emit the debug info into .dwo sections, next to a skeleton
+/// compile unit referring to the .dwo file (see DIBuilder::EmitCompileUnit).
+/// LLVM only exposes this as a (hidden) command line option.
+void enableSplitDwarf() {
+  auto &map = cl::getRegisteredOptions();
+  auto it = map.find("split-dwarf");
+  if (it == map.end()) {
+    error(Loc(), "-gsplit-dwarf is not supported by this LLVM version");
+    fatal();
+  }
+  it->second->addOccurrence(0, "split-dwarf", "Enable");
+}
+
 } // anonymous namespace
 
 int cppmain(int argc, char **argv) {
@@ -1002,6 +1048,18 @@ int cppmain(int argc, char **argv) {
   if (m64bits && (!m32bits || m32bits.getPosition() < m64bits.getPosition()))
     bitness = ExplicitBitness::M64;
 
+  DebugCompression::Type debugCompression = DebugCompression::None;
+  if (compressDebugSections.getNumOccurrences() > 0) {
+    if (compressDebugSections.empty() || compressDebugSections == "zlib") {
+      debugCompression = DebugCompression::Zlib;
+    } else if (compressDebugSections == "zlib-gnu") {
+      debugCompression = DebugCompression::ZlibGnu;
+    } else if (compressDebugSections != "none") {
+      error(Loc(), "unknown -gz format '%s' (expected none, zlib or zlib-gnu)",
+            compressDebugSections.c_str());
+    }
+  }
+
   if (global.errors) {
     fatal();
   }
@@ -1018,7 +1076,8 @@ int cppmain(int argc, char **argv) {
   gTargetMachine = createTargetMachine(
       mTargetTriple, arch, opts::getCPUStr(), opts::getFeaturesStr(), bitness,
       floatABI, relocModel, opts::getCodeModel(), codeGenOptLevel(),
-      disableLinkerStripDead);
+      // Code folding by the linker requires function sections too.
+      disableLinkerStripDead && !foldIdenticalCode, debugCompression);
 
   opts::setDefaultMathOptions(gTargetMachine->Options);
 
@@ -1049,6 +1108,15 @@ int cppmain(int argc, char **argv) {
       global.obj_ext = "obj";
   }
 
+  if (splitDwarf) {
+    if (global.params.targetTriple->isOSBinFormatELF()) {
+      enableSplitDwarf();
+    } else {
+      warning(Loc(), "-gsplit-dwarf is only supported for ELF targets");
+      splitDwarf = false;
+    }
+  }
+
   // allocate the target abi
   gABI = TargetABI::getTarget();
 
@@ -1072,6 +1140,10 @@ void addDefaultVersionIdentifiers() {
 void codegenModules(Modules &modules) {
   // Generate one or more object/IR/bitcode files/dcompute kernels.
   if (global.params.obj && !modules.empty()) {
+    if (opts::precomputeCtorOrder && !global.params.oneobj) {
+      warning(Loc(), "-precompute-ctor-order is ignored without -singleobj");
+    }
+
     ldc::CodeGenerator cg(getGlobalContext(), global.params.oneobj);
     DComputeCodeGenManager dccg(getGlobalContext());
     std::vector<Module *> computeModules;
@@ -1121,6 +1193,12 @@ void codegenModules(Modules &modules) {
     if (global.params.objfiles->dim == 0)
       global.params.link = false;
 
+#if LDC_WITH_PGO
+    if (!opts::symbolOrderingFile.empty()) {
+      writeSymbolOrderingFile(opts::symbolOrderingFile,
+                              /*UseSectionNames=*/opts::linker == "gold");
+    }
+#endif
   }
 
   cache::pruneCache();
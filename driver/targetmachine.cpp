@@ -82,7 +82,7 @@ static const char *getABI(const llvm::Triple &triple) {
   }
 }
 
-extern llvm::TargetMachine *gTargetMachine;
+extern LLVM_THREAD_LOCAL llvm::TargetMachine *gTargetMachine;
 
 MipsABI::Type getMipsABI() {
   // eabi can only be set on the commandline
@@ -353,7 +353,8 @@ createTargetMachine(const std::string targetTriple, const std::string arch,
 #endif
                     const llvm::CodeModel::Model codeModel,
                     const llvm::CodeGenOpt::Level codeGenOptLevel,
-                    const bool noLinkerStripDead) {
+                    const bool noLinkerStripDead,
+                    const DebugCompression::Type debugCompression) {
   // Determine target triple. If the user didn't explicitly specify one, use
   // the one set at LLVM configure time.
   llvm::Triple triple;
@@ -497,6 +498,25 @@ createTargetMachine(const std::string targetTriple, const std::string arch,
     targetOptions.DataSections = true;
   }
 
+  switch (debugCompression) {
+  case DebugCompression::None:
+    break;
+#if LDC_LLVM_VER >= 500
+  case DebugCompression::Zlib:
+    targetOptions.CompressDebugSections = llvm::DebugCompressionType::Z;
+    break;
+  case DebugCompression::ZlibGnu:
+    targetOptions.CompressDebugSections = llvm::DebugCompressionType::GNU;
+    break;
+#else
+  // Older LLVM versions only support the GNU format (.zdebug_* sections).
+  case DebugCompression::Zlib:
+  case DebugCompression::ZlibGnu:
+    targetOptions.CompressDebugSections = true;
+    break;
+#endif
+  }
+
   const std::string finalFeaturesString =
       llvm::join(features.begin(), features.end(), ",");
 
@@ -30,6 +30,10 @@ namespace FloatABI {
 enum Type { Default, Soft, SoftFP, Hard };
 }
 
+namespace DebugCompression {
+enum Type { None, Zlib, ZlibGnu };
+}
+
 namespace MipsABI {
 enum Type { Unknown, O32, N32, N64, EABI };
 }
@@ -64,7 +68,8 @@ createTargetMachine(std::string targetTriple, std::string arch, std::string cpu,
 #endif
                     llvm::CodeModel::Model codeModel,
                     llvm::CodeGenOpt::Level codeGenOptLevel,
-                    bool noLinkerStripDead);
+                    bool noLinkerStripDead,
+                    DebugCompression::Type debugCompression);
 
 /**
  * Returns the Mips ABI which is used for code generation.
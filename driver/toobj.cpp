@@ -48,6 +48,11 @@ static llvm::cl::opt<bool>
                           llvm::cl::Hidden,
                           llvm::cl::desc("Disable integrated assembler"));
 
+static llvm::cl::opt<std::string>
+    objcopy("objcopy", llvm::cl::ZeroOrMore, llvm::cl::value_desc("path"),
+            llvm::cl::desc("objcopy used to split off the debug info with "
+                           "-gsplit-dwarf"));
+
 // based on llc code, University of Illinois Open Source License
 static void codegenModule(llvm::TargetMachine &Target, llvm::Module &m,
                           llvm::raw_fd_ostream &out,
@@ -112,6 +117,40 @@ static void assemble(const std::string &asmpath, const std::string &objpath) {
   }
 }
 
+std::string getSplitDwarfFileName(llvm::StringRef objectFile) {
+  llvm::SmallString<128> dwoFile(objectFile);
+  llvm::sys::fs::make_absolute(dwoFile);
+  llvm::sys::path::replace_extension(dwoFile, "dwo");
+  return dwoFile.str();
+}
+
+// The object file emitted by LLVM contains both the skeleton compile unit and
+// the .dwo sections; move the latter into the .dwo file, like GCC and Clang
+// do.
+static void splitDebugInfo(const char *objpath) {
+  const std::string tool = getProgram("objcopy", &objcopy, "OBJCOPY");
+  const std::string dwopath = getSplitDwarfFileName(objpath);
+
+  std::vector<std::string> args;
+  args.push_back("--extract-dwo");
+  args.push_back(objpath);
+  args.push_back(dwopath);
+  if (executeToolAndWait(tool, args, global.params.verbose)) {
+    error(Loc(), "Error while extracting the split debug info to '%s'.",
+          dwopath.c_str());
+    fatal();
+  }
+
+  args.clear();
+  args.push_back("--strip-dwo");
+  args.push_back(objpath);
+  if (executeToolAndWait(tool, args, global.params.verbose)) {
+    error(Loc(), "Error while stripping the split debug info from '%s'.",
+          objpath);
+    fatal();
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -243,6 +282,11 @@ public:
   }
 };
 
+bool shouldSplitDebugInfo(llvm::Module *m) {
+  // dcompute modules don't contain any debug info
+  return opts::splitDwarf && getComputeTargetType(m) == ComputeBackend::None;
+}
+
 void writeObjectFile(llvm::Module *m, const char *filename) {
   IF_LOG Logger::println("Writing object file to: %s", filename);
   std::error_code errinfo;
@@ -258,6 +302,10 @@ void writeObjectFile(llvm::Module *m, const char *filename) {
       fatal();
     }
   }
+
+  if (shouldSplitDebugInfo(m)) {
+    splitDebugInfo(filename);
+  }
 }
 
 bool shouldAssembleExternally() {
@@ -299,9 +347,12 @@ void writeModule(llvm::Module *m, const char *filename) {
   const bool useIR2ObjCache = !opts::cacheDir.empty() && outputObj && !doLTO;
   llvm::SmallString<32> moduleHash;
   if (useIR2ObjCache) {
-    llvm::SmallString<128> cacheDir(opts::cacheDir.c_str());
-    llvm::sys::fs::make_absolute(cacheDir);
-    opts::cacheDir = cacheDir.c_str();
+    // Only assign once, DCompute modules may be written concurrently.
+    if (!llvm::sys::path::is_absolute(opts::cacheDir)) {
+      llvm::SmallString<128> cacheDir(opts::cacheDir.c_str());
+      llvm::sys::fs::make_absolute(cacheDir);
+      opts::cacheDir = cacheDir.c_str();
+    }
 
     IF_LOG Logger::println("Use IR-to-Object cache in %s",
                            opts::cacheDir.c_str());
@@ -422,6 +473,9 @@ void writeModule(llvm::Module *m, const char *filename) {
 
     if (assembleExternally) {
       assemble(spath, filename);
+      if (shouldSplitDebugInfo(m)) {
+        splitDebugInfo(filename);
+      }
     }
 
     if (!global.params.output_s) {
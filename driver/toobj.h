@@ -14,10 +14,17 @@
 #ifndef LDC_DRIVER_TOOBJ_H
 #define LDC_DRIVER_TOOBJ_H
 
+#include <string>
+
 namespace llvm {
 class Module;
+class StringRef;
 }
 
 void writeModule(llvm::Module *m, const char *filename);
 
+/// Returns the absolute path of the .dwo file accompanying the given object
+/// file with -gsplit-dwarf.
+std::string getSplitDwarfFileName(llvm::StringRef objectFile);
+
 #endif
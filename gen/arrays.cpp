@@ -1119,6 +1119,208 @@ LLValue *DtoArrayEqCmp_memcmp(Loc &loc, DValue *l, DValue *r, IRState &irs) {
 
   return phi;
 }
+
+/// How three-way comparisons of arrays (`object.__cmp`) can be lowered inline.
+enum class ArrayCmpLowering {
+  None,   /// Keep the call (e.g. floating point types, custom `opCmp`).
+  Memcmp, /// memcmp of the common prefix plus a length tie-break.
+  Loop,   /// Inline element-wise loop plus a length tie-break.
+};
+
+ArrayCmpLowering getArrayCmpLowering(Type *ltype, Type *rtype) {
+  ltype = ltype->toBasetype();
+  rtype = rtype->toBasetype();
+  if ((ltype->ty != Tarray && ltype->ty != Tsarray) ||
+      (rtype->ty != Tarray && rtype->ty != Tsarray))
+    return ArrayCmpLowering::None;
+
+  // Static and dynamic arrays of differently qualified elements may be
+  // compared, e.g. `const(ubyte)[]` and `ubyte[3]`.
+  auto *elemType = ltype->nextOf()->toBasetype();
+  if (!elemType->equivalent(rtype->nextOf()->toBasetype()))
+    return ArrayCmpLowering::None;
+
+  switch (elemType->ty) {
+  // memcmp compares unsigned bytes, which matches the element order.
+  case Tvoid:
+  case Tuns8:
+  case Tbool:
+  case Tchar:
+    return ArrayCmpLowering::Memcmp;
+
+  case Tint8:
+  case Tint16:
+  case Tuns16:
+  case Tint32:
+  case Tuns32:
+  case Tint64:
+  case Tuns64:
+  case Twchar:
+  case Tdchar:
+  case Tpointer:
+    return ArrayCmpLowering::Loop;
+
+  default:
+    return ArrayCmpLowering::None;
+  }
+}
+
+/// Returns the three-way comparison (-1, 0, 1) of the two lengths as i32.
+LLValue *compareArrayLengths(IRState &irs, LLValue *l_length,
+                             LLValue *r_length) {
+  auto lt = irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT, l_length, r_length);
+  auto gt = irs.ir->CreateICmp(llvm::ICmpInst::ICMP_UGT, l_length, r_length);
+  return irs.ir->CreateSelect(
+      lt, DtoConstInt(-1),
+      irs.ir->CreateSelect(gt, DtoConstInt(1), DtoConstInt(0)));
+}
+
+/// Three-way compares `l` and `r` using memcmp on the common prefix, breaking
+/// ties by length. No checks are done for validity.
+LLValue *DtoArrayCmp_memcmp(Loc &loc, DValue *l, DValue *r, IRState &irs) {
+  IF_LOG Logger::println("Comparing arrays using memcmp");
+
+  auto *l_length = DtoArrayLen(l);
+  auto *r_length = DtoArrayLen(r);
+  auto *minLength = irs.ir->CreateSelect(
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT, l_length, r_length),
+      l_length, r_length);
+
+  // As for equality, no null checks are needed: memcmp returns 0 for a zero
+  // length.
+  auto memcmpAnswer =
+      callMemcmp(loc, irs, DtoArrayPtr(l), DtoArrayPtr(r), minLength);
+  auto prefixEqual =
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_EQ, memcmpAnswer, DtoConstInt(0));
+  return irs.ir->CreateSelect(
+      prefixEqual, compareArrayLengths(irs, l_length, r_length), memcmpAnswer);
+}
+
+/// Three-way compares `l` and `r` element by element using inline loops,
+/// breaking ties by length. No checks are done for validity.
+///
+/// The common prefix is first scanned in fixed-size blocks without an early
+/// exit (OR-ing the XOR of the elements), which the loop vectorizer can turn
+/// into SIMD code. The first block containing a difference and the remaining
+/// tail are then scanned element by element.
+LLValue *DtoArrayCmp_loop(Loc &loc, DValue *l, DValue *r, IRState &irs) {
+  IF_LOG Logger::println("Comparing arrays using inline loops");
+
+  Type *elemType = l->type->toBasetype()->nextOf()->toBasetype();
+  const bool isUnsigned = isLLVMUnsigned(elemType);
+
+  // Compare pointers as integers, so that they can be XOR'ed.
+  const uint64_t elemSize = getTypeAllocSize(DtoType(elemType));
+  LLType *elemPtrType =
+      LLIntegerType::get(irs.context(), elemSize * 8)->getPointerTo();
+  auto *l_ptr = DtoBitCast(DtoArrayPtr(l), elemPtrType);
+  auto *r_ptr = DtoBitCast(DtoArrayPtr(r), elemPtrType);
+  auto *l_length = DtoArrayLen(l);
+  auto *r_length = DtoArrayLen(r);
+  auto *minLength = irs.ir->CreateSelect(
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT, l_length, r_length),
+      l_length, r_length);
+
+  // 64 bytes per block (a power of two, as the element size is).
+  const uint64_t blockLength = std::max<uint64_t>(1, 64 / elemSize);
+  auto *blocksEnd =
+      irs.ir->CreateAnd(minLength, DtoConstSize_t(~(blockLength - 1)));
+
+  llvm::BasicBlock *entryBB = irs.scopebb();
+  llvm::BasicBlock *blockCondBB = irs.insertBB("arraycmp.block.cond");
+  llvm::BasicBlock *blockBodyBB =
+      irs.insertBBAfter(blockCondBB, "arraycmp.block");
+  llvm::BasicBlock *blockEndBB =
+      irs.insertBBAfter(blockBodyBB, "arraycmp.block.end");
+  llvm::BasicBlock *scanBB = irs.insertBBAfter(blockEndBB, "arraycmp.scan");
+  llvm::BasicBlock *condBB = irs.insertBBAfter(scanBB, "arraycmp.cond");
+  llvm::BasicBlock *bodyBB = irs.insertBBAfter(condBB, "arraycmp.body");
+  llvm::BasicBlock *nextBB = irs.insertBBAfter(bodyBB, "arraycmp.next");
+  llvm::BasicBlock *differBB = irs.insertBBAfter(nextBB, "arraycmp.differ");
+  llvm::BasicBlock *tieBB = irs.insertBBAfter(differBB, "arraycmp.tie");
+  llvm::BasicBlock *endBB = irs.insertBBAfter(tieBB, "arraycmp.end");
+  irs.ir->CreateBr(blockCondBB);
+
+  // Loop over the full blocks of the common prefix.
+  irs.scope() = IRScope(blockCondBB);
+  llvm::PHINode *blockStart =
+      irs.ir->CreatePHI(DtoSize_t(), 2, "arraycmp.block.start");
+  blockStart->addIncoming(DtoConstSize_t(0), entryBB);
+  auto *blockLimit =
+      irs.ir->CreateAdd(blockStart, DtoConstSize_t(blockLength));
+  irs.ir->CreateCondBr(
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT, blockStart, blocksEnd),
+      blockBodyBB, scanBB);
+
+  // Fixed trip count and no early exit, so that the loop can be vectorized.
+  irs.scope() = IRScope(blockBodyBB);
+  llvm::PHINode *blockIndex =
+      irs.ir->CreatePHI(DtoSize_t(), 2, "arraycmp.block.index");
+  blockIndex->addIncoming(blockStart, blockCondBB);
+  llvm::PHINode *blockDiff = irs.ir->CreatePHI(
+      elemPtrType->getPointerElementType(), 2, "arraycmp.block.diff");
+  blockDiff->addIncoming(
+      llvm::ConstantInt::get(elemPtrType->getPointerElementType(), 0),
+      blockCondBB);
+  auto *diff = irs.ir->CreateOr(
+      blockDiff,
+      irs.ir->CreateXor(DtoLoad(DtoGEP1(l_ptr, blockIndex, true)),
+                        DtoLoad(DtoGEP1(r_ptr, blockIndex, true))));
+  auto *nextBlockIndex = irs.ir->CreateAdd(blockIndex, DtoConstSize_t(1));
+  blockIndex->addIncoming(nextBlockIndex, blockBodyBB);
+  blockDiff->addIncoming(diff, blockBodyBB);
+  irs.ir->CreateCondBr(irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT,
+                                          nextBlockIndex, blockLimit),
+                       blockBodyBB, blockEndBB);
+
+  irs.scope() = IRScope(blockEndBB);
+  blockStart->addIncoming(blockLimit, blockEndBB);
+  irs.ir->CreateCondBr(irs.ir->CreateIsNull(diff), blockCondBB, scanBB);
+
+  // Scan the differing block (or the tail) element by element.
+  irs.scope() = IRScope(scanBB);
+  irs.ir->CreateBr(condBB);
+
+  irs.scope() = IRScope(condBB);
+  llvm::PHINode *index = irs.ir->CreatePHI(DtoSize_t(), 2, "arraycmp.index");
+  index->addIncoming(blockStart, scanBB);
+  irs.ir->CreateCondBr(
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_ULT, index, minLength), bodyBB,
+      tieBB);
+
+  irs.scope() = IRScope(bodyBB);
+  auto *l_elem = DtoLoad(DtoGEP1(l_ptr, index, true));
+  auto *r_elem = DtoLoad(DtoGEP1(r_ptr, index, true));
+  irs.ir->CreateCondBr(
+      irs.ir->CreateICmp(llvm::ICmpInst::ICMP_EQ, l_elem, r_elem), nextBB,
+      differBB);
+
+  irs.scope() = IRScope(nextBB);
+  index->addIncoming(irs.ir->CreateAdd(index, DtoConstSize_t(1)), nextBB);
+  irs.ir->CreateBr(condBB);
+
+  // First differing element decides.
+  irs.scope() = IRScope(differBB);
+  auto lt = irs.ir->CreateICmp(isUnsigned ? llvm::ICmpInst::ICMP_ULT
+                                          : llvm::ICmpInst::ICMP_SLT,
+                               l_elem, r_elem);
+  auto *differAnswer =
+      irs.ir->CreateSelect(lt, DtoConstInt(-1), DtoConstInt(1));
+  irs.ir->CreateBr(endBB);
+
+  // Common prefix is equal, the shorter array is the lesser one.
+  irs.scope() = IRScope(tieBB);
+  auto *tieAnswer = compareArrayLengths(irs, l_length, r_length);
+  irs.ir->CreateBr(endBB);
+
+  irs.scope() = IRScope(endBB);
+  llvm::PHINode *phi =
+      irs.ir->CreatePHI(LLType::getInt32Ty(gIR->context()), 2, "cmp_result");
+  phi->addIncoming(differAnswer, differBB);
+  phi->addIncoming(tieAnswer, tieBB);
+
+  return phi;
+}
 } // end anonymous namespace
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1165,6 +1367,23 @@ LLValue *DtoArrayCompare(Loc &loc, TOK op, DValue *l, DValue *r) {
   return res;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+bool canInlineArrayCmp(Type *lhs, Type *rhs) {
+  return getArrayCmpLowering(lhs, rhs) != ArrayCmpLowering::None;
+}
+
+LLValue *DtoInlineArrayCmp(Loc &loc, DValue *l, DValue *r) {
+  switch (getArrayCmpLowering(l->type, r->type)) {
+  case ArrayCmpLowering::Memcmp:
+    return DtoArrayCmp_memcmp(loc, l, r, *gIR);
+  case ArrayCmpLowering::Loop:
+    return DtoArrayCmp_loop(loc, l, r, *gIR);
+  case ArrayCmpLowering::None:
+    break;
+  }
+  llvm_unreachable("Array comparison cannot be lowered inline.");
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 LLValue *DtoArrayCastLength(Loc &loc, LLValue *len, LLType *elemty,
                             LLType *newelemty) {
@@ -76,6 +76,13 @@ DSliceValue *DtoAppendDCharToUnicodeString(Loc &loc, DValue *arr,
 LLValue *DtoArrayEquals(Loc &loc, TOK op, DValue *l, DValue *r);
 LLValue *DtoArrayCompare(Loc &loc, TOK op, DValue *l, DValue *r);
 
+/// Returns whether the three-way comparison of arrays of the given types (as
+/// done by `object.__cmp`) can be lowered inline by DtoInlineArrayCmp().
+bool canInlineArrayCmp(Type *lhs, Type *rhs);
+/// Emits the three-way comparison of two arrays, yielding a negative i32 if
+/// `l < r`, zero if they are equal and a positive one if `l > r`.
+LLValue *DtoInlineArrayCmp(Loc &loc, DValue *l, DValue *r);
+
 LLValue *DtoDynArrayIs(TOK op, DValue *l, DValue *r);
 
 LLValue *DtoArrayCastLength(Loc &loc, LLValue *len, LLType *elemty,
@@ -11,8 +11,10 @@
 
 #include "mars.h"
 #include "module.h"
+#include "driver/cl_options.h"
 #include "gen/irstate.h"
 #include "gen/logger.h"
+#include "llvm/IR/MDBuilder.h"
 
 void emitCoverageLinecountInc(Loc &loc) {
   Module *m = gIR->dmodule;
@@ -37,14 +39,43 @@ void emitCoverageLinecountInc(Loc &loc) {
       LLArrayType::get(LLType::getInt32Ty(gIR->context()), m->numlines),
       m->d_cover_data, idxs, true);
 
-  // Do an atomic increment, so this works when multiple threads are executed.
-  gIR->ir->CreateAtomicRMW(llvm::AtomicRMWInst::Add, ptr, DtoConstUint(1),
+  switch (opts::coverageIncrement) {
+  case opts::CoverageIncrement::atomic:
+    // Do an atomic increment, so this works when multiple threads are executed.
+    gIR->ir->CreateAtomicRMW(llvm::AtomicRMWInst::Add, ptr, DtoConstUint(1),
 #if LDC_LLVM_VER >= 309
-                           llvm::AtomicOrdering::Monotonic
+                             llvm::AtomicOrdering::Monotonic
 #else
-                           llvm::Monotonic
+                             llvm::Monotonic
 #endif
-  );
+    );
+    break;
+
+  case opts::CoverageIncrement::nonAtomic: {
+    // Plain increment, avoiding the cache-line contention of atomics at the
+    // cost of possibly lost counts when multiple threads are executed.
+    LLValue *count = gIR->ir->CreateLoad(ptr);
+    gIR->ir->CreateStore(gIR->ir->CreateAdd(count, DtoConstUint(1)), ptr);
+    break;
+  }
+
+  case opts::CoverageIncrement::boolean: {
+    // Only record that the line has been executed (count of 1). Test before
+    // storing, so that lines already hit cause no further writes.
+    llvm::BasicBlock *setBB = gIR->insertBB("cov.set");
+    llvm::BasicBlock *endBB = gIR->insertBBAfter(setBB, "cov.end");
+    LLValue *count = gIR->ir->CreateLoad(ptr);
+    LLValue *isHit = gIR->ir->CreateICmpNE(count, DtoConstUint(0));
+    gIR->ir->CreateCondBr(isHit, endBB, setBB,
+                          llvm::MDBuilder(gIR->context())
+                              .createBranchWeights(1000, 1));
+    gIR->scope() = IRScope(setBB);
+    gIR->ir->CreateStore(DtoConstUint(1), ptr);
+    gIR->ir->CreateBr(endBB);
+    gIR->scope() = IRScope(endBB);
+    break;
+  }
+  }
 
   unsigned num_sizet_bits = gDataLayout->getTypeSizeInBits(DtoSize_t());
   unsigned idx = line / num_sizet_bits;
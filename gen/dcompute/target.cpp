@@ -42,7 +42,7 @@ void DComputeTarget::emit(Module *m) {
   doCodeGen(m);
 }
 
-void DComputeTarget::writeModule() {
+std::string DComputeTarget::finalizeModule() {
   addMetadata();
 
   std::string filename;
@@ -50,10 +50,14 @@ void DComputeTarget::writeModule() {
   os << opts::dcomputeFilePrefix << '_' << short_name << tversion << '_'
      << (global.params.is64bit ? 64 : 32) << '.' << binSuffix;
 
-  const char *path = FileName::combine(global.params.objdir, os.str().c_str());
+  return FileName::combine(global.params.objdir, os.str().c_str());
+}
+
+void DComputeTarget::writeModule() {
+  const std::string path = finalizeModule();
 
   setGTargetMachine();
-  ::writeModule(&_ir->module, path);
+  ::writeModule(&_ir->module, path.c_str());
 
   delete _ir;
   _ir = nullptr;
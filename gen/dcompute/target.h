@@ -45,6 +45,8 @@ public:
 
   void emit(Module *m);
   void doCodeGen(Module *m);
+  // Adds the target specific metadata and returns the kernel file path.
+  std::string finalizeModule();
   void writeModule();
 
   // HACK: Resets the gTargetMachine to one appropriate for this dcompute target
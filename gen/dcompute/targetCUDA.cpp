@@ -57,7 +57,7 @@ public:
         is64 ? "nvptx64" : "nvptx", "sm_" + ldc::to_string(tversion / 10), {},
         is64 ? ExplicitBitness::M64 : ExplicitBitness::M32, ::FloatABI::Hard,
         llvm::Reloc::Static, llvm::CodeModel::Medium, codeGenOptLevel(),
-        false);
+        false, DebugCompression::None);
   }
 
   void addKernelMetadata(FuncDeclaration *df, llvm::Function *llf) override {
@@ -99,6 +99,8 @@ public:
         interfaceZ->setInitializer(ir->getClassInfoInit());
         setLinkage(decl, interfaceZ);
       }
+
+      irs->DBuilder.EmitAggregateType(decl);
     }
   }
 
@@ -154,6 +156,8 @@ public:
     if (decl->xhash) {
       decl->xhash->accept(this);
     }
+
+    irs->DBuilder.EmitAggregateType(decl);
   }
 
   //////////////////////////////////////////////////////////////////////////
@@ -200,6 +204,8 @@ public:
         classZ->setInitializer(ir->getClassInfoInit());
         setLinkage(lwc, classZ);
       }
+
+      irs->DBuilder.EmitAggregateType(decl);
     }
   }
 
@@ -291,6 +297,7 @@ public:
         // match.
         irGlobal->value = irs->setGlobalVarInitializer(gvar, initVal);
         setLinkage(lwc, gvar);
+        setThreadLocalModeForDefinition(gvar);
 
         // Also set up the debug info.
         irs->DBuilder.EmitGlobalVariable(gvar, decl);
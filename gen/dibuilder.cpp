@@ -11,6 +11,7 @@
 
 #include "driver/cl_options.h"
 #include "driver/ldc-version.h"
+#include "driver/toobj.h"
 #include "gen/functions.h"
 #include "gen/irstate.h"
 #include "gen/llvmhelpers.h"
@@ -87,7 +88,7 @@ Module *ldc::DIBuilder::getDefinedModule(Dsymbol *s) {
   }
   // array operations as well
   if (FuncDeclaration *fd = s->isFuncDeclaration()) {
-    if (fd->isArrayOp && (willInline() || !isDruntimeArrayOp(fd))) {
+    if (isInlineArrayOp(fd)) {
       return IR->dmodule;
     }
   }
@@ -434,11 +435,10 @@ ldc::DIType ldc::DIBuilder::CreateCompositeType(Type *type) {
   LLType *T = DtoType(sd->type);
   if (t->ty == Tclass)
     T = llvm::cast<llvm::PointerType>(T)->getElementType();
-  IrTypeAggr *ir = sd->type->ctype->isAggr();
-  assert(ir);
 
-  if (static_cast<llvm::MDNode *>(ir->diCompositeType) != nullptr) {
-    return ir->diCompositeType;
+  llvm::TrackingMDRef &cached = compositeTypeCache[sd];
+  if (cached) {
+    return llvm::cast<llvm::DIType>(cached.get());
   }
 
   // if we don't know the aggregate's size, we don't know enough about it
@@ -458,11 +458,25 @@ ldc::DIType ldc::DIBuilder::CreateCompositeType(Type *type) {
   ldc::DIFile file = CreateFile(sd);
   ldc::DIType derivedFrom = getNullDIType();
 
-  // set diCompositeType to handle recursive types properly
   unsigned tag = (t->ty == Tstruct) ? llvm::dwarf::DW_TAG_structure_type
                                     : llvm::dwarf::DW_TAG_class_type;
-  ir->diCompositeType = DBuilder.createReplaceableCompositeType(
-      tag, name, CU, file, linnum);
+
+  // with -flimit-debug-info, only declare aggregates defined in other modules;
+  // their full description is emitted along with the defining module
+  if (opts::limitDebugInfo && getDefinedModule(sd) != IR->dmodule) {
+    ldc::DIType decl = DBuilder.createForwardDecl(tag, name, CU, file, linnum,
+                                                  0,     // RunTimeLang
+                                                  0,     // size in bits
+                                                  0,     // alignment in bits
+                                                  uniqueIdent(t));
+    cached.reset(decl);
+    return decl;
+  }
+
+  // cache a temporary forward reference to handle recursive types properly
+  auto fwd = DBuilder.createReplaceableCompositeType(tag, name, CU, file,
+                                                     linnum);
+  cached.reset(fwd);
 
   if (!sd->isInterfaceDeclaration()) // plain interfaces don't have one
   {
@@ -523,9 +537,9 @@ ldc::DIType ldc::DIBuilder::CreateCompositeType(Type *type) {
                                     uniqueIdent(t)); // UniqueIdentifier
   }
 
-  ir->diCompositeType = DBuilder.replaceTemporary(
-      llvm::TempDINode(ir->diCompositeType), static_cast<llvm::DIType *>(ret));
-  ir->diCompositeType = ret;
+  DBuilder.replaceTemporary(llvm::TempDINode(fwd),
+                            static_cast<llvm::DIType *>(ret));
+  compositeTypeCache[sd].reset(ret);
 
   return ret;
 }
@@ -656,7 +670,31 @@ bool isOpaqueEnumType(Type *type) {
   return !te->sym->memtype;
 }
 
+void ldc::DIBuilder::ResetTypeCachesForModule() {
+  // With -flimit-debug-info, whether an aggregate is only declared depends on
+  // the D module being compiled, and several modules share one compile unit
+  // with -singleobj.
+  if (opts::limitDebugInfo && typeCacheModule != IR->dmodule) {
+    typeCache.clear();
+    compositeTypeCache.clear();
+    typeCacheModule = IR->dmodule;
+  }
+}
+
 ldc::DIType ldc::DIBuilder::CreateTypeDescription(Type *type) {
+  ResetTypeCachesForModule();
+
+  auto it = typeCache.find(type);
+  if (it != typeCache.end()) {
+    return llvm::cast_or_null<llvm::DIType>(it->second.get());
+  }
+
+  ldc::DIType ret = CreateUncachedTypeDescription(type);
+  typeCache[type].reset(ret);
+  return ret;
+}
+
+ldc::DIType ldc::DIBuilder::CreateUncachedTypeDescription(Type *type) {
   // Check for opaque enum first, Bugzilla 13792
   if (isOpaqueEnumType(type))
     return DBuilder.createUnspecifiedType(type->toChars());
@@ -763,6 +801,11 @@ void ldc::DIBuilder::EmitCompileUnit(Module *m) {
   auto producerName = std::string("LDC ") + ldc::ldc_version + " (LLVM " +
                       ldc::llvm_version + ")";
 
+  // with -gsplit-dwarf, the skeleton compile unit refers to the .dwo file
+  const std::string splitName =
+      opts::splitDwarf ? getSplitDwarfFileName(m->objfile->name->toChars())
+                       : std::string();
+
 #if LDC_LLVM_VER >= 308
   if (global.params.targetTriple->isWindowsMSVCEnvironment())
     IR->module.addModuleFlag(llvm::Module::Warning, "CodeView", 1);
@@ -787,7 +830,7 @@ void ldc::DIBuilder::EmitCompileUnit(Module *m) {
       isOptimizationEnabled(), // isOptimized
       llvm::StringRef(),       // Flags TODO
       1,                       // Runtime Version TODO
-      llvm::StringRef(),       // SplitName
+      splitName,               // SplitName
       getDebugEmissionKind(),  // DebugEmissionKind
       0                        // DWOId
 #if LDC_LLVM_VER < 309
@@ -1200,6 +1243,21 @@ void ldc::DIBuilder::EmitGlobalVariable(llvm::GlobalVariable *llVar,
 #endif
 }
 
+void ldc::DIBuilder::EmitAggregateType(AggregateDeclaration *ad) {
+  if (!opts::limitDebugInfo || !mustEmitFullDebugInfo())
+    return;
+
+  // template instances are fully described by each module using them
+  if (DtoIsTemplateInstance(ad))
+    return;
+
+  IF_LOG Logger::println("D to dwarf aggregate type: %s", ad->toPrettyChars());
+  LOG_SCOPE;
+
+  ResetTypeCachesForModule();
+  DBuilder.retainType(CreateCompositeType(ad->type));
+}
+
 void ldc::DIBuilder::Finalize() {
   if (!mustEmitLocationsDebugInfo())
     return;
@@ -10,17 +10,20 @@
 #ifndef LDC_GEN_DIBUILDER_H
 #define LDC_GEN_DIBUILDER_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfo.h"
 #include "llvm/IR/DIBuilder.h"
+#include "llvm/IR/TrackingMDRef.h"
 
 #include "gen/tollvm.h"
 #include "mars.h"
 
 struct IRState;
 
+class AggregateDeclaration;
 class ClassDeclaration;
 class Dsymbol;
 class FuncDeclaration;
@@ -68,6 +71,19 @@ class DIBuilder {
 
   Loc currentLoc;
 
+  /// Type descriptions created for this compile unit, keyed by D type.
+  /// Tracking references are used as the descriptions of recursive types are
+  /// resolved (and possibly re-uniqued) only after they have been cached.
+  llvm::DenseMap<Type *, llvm::TrackingMDRef> typeCache;
+
+  /// Composite types created for this compile unit, including the temporary
+  /// forward references used while an aggregate is being described.
+  llvm::DenseMap<AggregateDeclaration *, llvm::TrackingMDRef>
+      compositeTypeCache;
+
+  /// The D module the caches above were filled for (-flimit-debug-info).
+  Module *typeCacheModule = nullptr;
+
 public:
   explicit DIBuilder(IRState *const IR);
 
@@ -140,6 +156,12 @@ public:
   void EmitGlobalVariable(llvm::GlobalVariable *ll,
                           VarDeclaration *vd); // FIXME
 
+  /// \brief Emits the full type description of an aggregate defined in the
+  /// current module, so that other modules compiled with -flimit-debug-info
+  /// can refer to it by declaration only.
+  /// \param ad       Aggregate declaration to emit debug info for.
+  void EmitAggregateType(AggregateDeclaration *ad);
+
   void Finalize();
 
 private:
@@ -170,6 +192,8 @@ private:
   DISubroutineType CreateEmptyFunctionType();
   DIType CreateDelegateType(Type *type);
   DIType CreateTypeDescription(Type *type);
+  DIType CreateUncachedTypeDescription(Type *type);
+  void ResetTypeCachesForModule();
 
   bool mustEmitFullDebugInfo();
   bool mustEmitLocationsDebugInfo();
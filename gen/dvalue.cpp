@@ -14,6 +14,7 @@
 #include "gen/llvmhelpers.h"
 #include "gen/logger.h"
 #include "gen/optimizer.h"
+#include "gen/tbaa.h"
 #include "gen/tollvm.h"
 #include "llvm/IR/MDBuilder.h"
 
@@ -107,7 +108,8 @@ bool DFuncValue::definedInFuncEntryBB() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-DLValue::DLValue(Type *t, LLValue *v) : DValue(t, v) {
+DLValue::DLValue(Type *t, LLValue *v, bool typePunned)
+    : DValue(t, v), typePunned(typePunned) {
   // v may be an addrspace qualified pointer so strip it before doing a pointer
   // equality check.
   assert(t->toBasetype()->ty == Ttuple ||
@@ -121,6 +123,7 @@ DRValue *DLValue::getRVal() {
   }
 
   LLValue *rval = DtoLoad(val);
+  addTBAAMetadata(llvm::cast<llvm::LoadInst>(rval), this);
   if (type->toBasetype()->ty == Tbool) {
     assert(rval->getType() == llvm::Type::getInt8Ty(gIR->context()));
 
@@ -148,7 +148,12 @@ public:
 /// keep structs and static arrays in memory.
 class DLValue : public DValue {
 public:
-  DLValue(Type *t, llvm::Value *v);
+  /// True if the memory might have been stored as another type (overlapping
+  /// union member, reinterpreting pointer cast), so that loads and stores must
+  /// not be tagged with the TBAA type of this value.
+  const bool typePunned;
+
+  DLValue(Type *t, llvm::Value *v, bool typePunned = false);
 
   DRValue *getRVal() override;
   virtual DLValue *getLVal() { return this; }
@@ -156,7 +161,7 @@ public:
   DLValue *isLVal() override { return this; }
 
 protected:
-  DLValue(llvm::Value *v, Type *t) : DValue(t, v) {}
+  DLValue(llvm::Value *v, Type *t) : DValue(t, v), typePunned(false) {}
 
   friend llvm::Value *DtoLVal(DValue *v);
 };
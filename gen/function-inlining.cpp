@@ -19,27 +19,59 @@
 #include "gen/optimizer.h"
 #include "gen/recursivevisitor.h"
 #include "gen/uda.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/CommandLine.h"
+
+static llvm::cl::opt<unsigned> crossModuleInlineThreshold(
+    "cross-module-inline-threshold", llvm::cl::ZeroOrMore, llvm::cl::Hidden,
+    llvm::cl::init(15),
+    llvm::cl::desc("Maximum estimated cost of an imported function for its "
+                   "body to be made available for inlining"));
 
 namespace {
 
-/// An ASTVisitor that checks whether the number of statements is larger than a
-/// certain number.
-struct MoreThanXStatements : public StoppableVisitor {
-  /// Are there more or fewer statements than `threshold`?.
-  unsigned threshold;
-  /// The statement count.
-  unsigned count;
+/// The decisions of defineAsExternallyAvailable() that required looking at the
+/// function body. Reused by all modules of this compiler invocation, as the
+/// body is only analyzed once.
+llvm::DenseMap<FuncDeclaration *, bool> inlineDecisions;
 
-  explicit MoreThanXStatements(unsigned X) : threshold(X), count(0) {}
+/// An ASTVisitor estimating the size of the code generated for a function
+/// body, stopping as soon as the estimate exceeds a certain threshold.
+struct InlineCostEstimator : public StoppableVisitor {
+  /// The maximum cost.
+  unsigned threshold;
+  /// The estimated cost so far.
+  unsigned cost;
 
-  using StoppableVisitor::visit;
+  explicit InlineCostEstimator(unsigned X) : threshold(X), cost(0) {}
 
-  void visit(Statement *stmt) override {
-    count++;
-    if (count > threshold)
+  void add(unsigned c) {
+    cost += c;
+    if (cost > threshold)
       stop = true;
   }
+
+  using StoppableVisitor::visit;
+
+  void visit(Statement *stmt) override { add(1); }
+  // Loops are likely to be unrolled/vectorized, and exception handling and
+  // inline asm need a lot of extra code.
+  void visit(WhileStatement *stmt) override { add(3); }
+  void visit(DoStatement *stmt) override { add(3); }
+  void visit(ForStatement *stmt) override { add(3); }
+  void visit(ForeachStatement *stmt) override { add(3); }
+  void visit(ForeachRangeStatement *stmt) override { add(3); }
+  void visit(TryCatchStatement *stmt) override { add(5); }
+  void visit(TryFinallyStatement *stmt) override { add(5); }
+  void visit(OnScopeStatement *stmt) override { add(5); }
+  void visit(SynchronizedStatement *stmt) override { add(5); }
+  void visit(AsmStatement *stmt) override { add(5); }
+
   void visit(Expression *exp) override {}
+  // Each call can pull in yet another imported function body.
+  void visit(CallExp *exp) override { add(1); }
+  void visit(NewExp *exp) override { add(1); }
+
   void visit(Declaration *decl) override {}
   void visit(Initializer *init) override {}
   void visit(Dsymbol *) override {}
@@ -49,22 +81,18 @@ struct MoreThanXStatements : public StoppableVisitor {
 // Note: isInlineCandidate is called _before_ semantic3 analysis of fdecl.
 bool isInlineCandidate(FuncDeclaration &fdecl) {
   // Giving maximum inlining potential to LLVM should be possible, but we
-  // restrict it to save some compile time.
-  // return true;
-
-  // TODO: make the heuristic more sophisticated?
+  // restrict it to save some compile time: each body made available requires
+  // semantic analysis and codegen, even if LLVM then decides not to inline it.
   // In the end, LLVM will make the decision whether to _actually_ inline.
-  // The statement count threshold is completely arbitrary. Also, all
-  // statements are weighed the same.
 
-  unsigned statementThreshold = 10;
-  MoreThanXStatements statementCounter(statementThreshold);
-  RecursiveWalker walker(&statementCounter, false);
+  const unsigned threshold = crossModuleInlineThreshold;
+  InlineCostEstimator estimator(threshold);
+  RecursiveWalker walker(&estimator, false);
   fdecl.fbody->accept(&walker);
 
-  IF_LOG Logger::println("Contains %u statements or more (threshold = %u).",
-                         statementCounter.count, statementThreshold);
-  return statementCounter.count <= statementThreshold;
+  IF_LOG Logger::println("Estimated cost is %u or more (threshold = %u).",
+                         estimator.cost, threshold);
+  return estimator.cost <= threshold;
 }
 
 } // end anonymous namespace
@@ -145,6 +173,14 @@ bool defineAsExternallyAvailable(FuncDeclaration &fdecl) {
     return false;
   }
 
+  // The semantic analysis below is done only once per invocation.
+  auto cached = inlineDecisions.find(&fdecl);
+  if (cached != inlineDecisions.end()) {
+    IF_LOG Logger::println("Reusing earlier decision: %s",
+                           cached->second ? "yes" : "no");
+    return cached->second;
+  }
+
   if (fdecl.semanticRun >= PASSsemantic3) {
     // If semantic analysis has come this far, the function will be defined
     // elsewhere and should not get the available_externally attribute from
@@ -167,8 +203,10 @@ bool defineAsExternallyAvailable(FuncDeclaration &fdecl) {
     return false;
   }
 
-  if (fdecl.inlining != PINLINEalways && !isInlineCandidate(fdecl))
+  if (fdecl.inlining != PINLINEalways && !isInlineCandidate(fdecl)) {
+    inlineDecisions[&fdecl] = false;
     return false;
+  }
 
   IF_LOG Logger::println("Potential inlining candidate");
 
@@ -192,6 +230,7 @@ bool defineAsExternallyAvailable(FuncDeclaration &fdecl) {
     global.gaggedForInlining = false;
     if (global.endGagging(errors) || semantic_error) {
       IF_LOG Logger::println("Errors occured during semantic analysis.");
+      inlineDecisions[&fdecl] = false;
       return false;
     }
     assert(fdecl.semanticRun >= PASSsemantic3done);
@@ -201,9 +240,11 @@ bool defineAsExternallyAvailable(FuncDeclaration &fdecl) {
   // and so this check can only be done at this late point.
   if (fdecl.naked) {
     IF_LOG Logger::println("Naked asm functions cannot be inlined.");
+    inlineDecisions[&fdecl] = false;
     return false;
   }
 
   IF_LOG Logger::println("defineAsExternallyAvailable? Yes.");
+  inlineDecisions[&fdecl] = true;
   return true;
 }
@@ -44,12 +44,31 @@
 #include "gen/uda.h"
 #include "ir/irfunction.h"
 #include "ir/irmodule.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Target/TargetOptions.h"
 #include <iostream>
 
+static llvm::cl::opt<llvm::cl::boolOrDefault, false,
+                     opts::FlagParser<llvm::cl::boolOrDefault>>
+    inlineArrayOps(
+        "inline-arrayops", llvm::cl::ZeroOrMore,
+        llvm::cl::desc("(*) Lower array operations to inline, vectorizable "
+                       "loops instead of calling the druntime implementations "
+                       "(default with -O1 and higher)"));
+
+static llvm::cl::opt<bool> disableTemplateInstanceDedup(
+    "disable-template-instance-dedup", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Define template instances in every object file using "
+                   "them, even if all object files are linked together"));
+
+static llvm::cl::opt<bool> disableNothrowInference(
+    "disable-nothrow-inference", llvm::cl::ZeroOrMore, llvm::cl::Hidden,
+    llvm::cl::desc("Disable nothrow inference for non-templated functions at "
+                   "codegen time"));
+
 llvm::FunctionType *DtoFunctionType(Type *type, IrFuncTy &irFty, Type *thistype,
                                     Type *nesttype, bool isMain, bool isCtor,
                                     bool isIntrinsic, bool hasSel) {
@@ -162,6 +181,11 @@ llvm::FunctionType *DtoFunctionType(Type *type, IrFuncTy &irFty, Type *thistype,
     } else if (passPointer) {
       // ref/out
       attrs.addDereferenceable(loweredDType->size());
+      // A D callee cannot write to const/immutable data passed by ref (unlike
+      // C/C++, where casting away const is legal).
+      if (f->linkage == LINKd && !loweredDType->isMutable()) {
+        attrs.add(LLAttribute::ReadOnly);
+      }
     } else {
       if (abi->passByVal(loweredDType)) {
         // LLVM ByVal parameters are pointers to a copy in the function
@@ -172,6 +196,12 @@ llvm::FunctionType *DtoFunctionType(Type *type, IrFuncTy &irFty, Type *thistype,
       } else {
         // Add sext/zext as needed.
         attrs.add(DtoShouldExtend(loweredDType));
+        // Ditto for pointers to const/immutable data.
+        Type *bt = loweredDType->toBasetype();
+        if (f->linkage == LINKd && bt->ty == Tpointer &&
+            !bt->nextOf()->isMutable()) {
+          attrs.add(LLAttribute::ReadOnly);
+        }
       }
     }
 
@@ -420,6 +450,95 @@ void applyParamAttrsToLLFunc(TypeFunction *f, IrFuncTy &irFty,
   func->setAttributes(newAttrs);
 }
 
+/// Returns true if none of the explicit parameters refers to mutable or const
+/// memory.
+bool hasOnlyImmutableIndirections(TypeFunction *tf) {
+  if (tf->varargs) {
+    return false;
+  }
+  const size_t n = Parameter::dim(tf->parameters);
+  for (size_t i = 0; i < n; ++i) {
+    Parameter *p = Parameter::getNth(tf->parameters, i);
+    if (p->storageClass & (STCref | STCout | STClazy)) {
+      return false;
+    }
+    Type *t = p->type->baseElemOf();
+    if (!t->hasPointers() || t->isImmutable()) {
+      continue;
+    }
+    if ((t->ty == Tarray || t->ty == Tpointer) &&
+        t->nextOf()->isImmutable()) {
+      continue;
+    }
+    return false;
+  }
+  return true;
+}
+
+/// Returns true if none of the explicit parameters refers to memory at all.
+bool hasNoIndirections(TypeFunction *tf) {
+  if (tf->varargs) {
+    return false;
+  }
+  const size_t n = Parameter::dim(tf->parameters);
+  for (size_t i = 0; i < n; ++i) {
+    Parameter *p = Parameter::getNth(tf->parameters, i);
+    if ((p->storageClass & (STCref | STCout | STClazy)) ||
+        p->type->hasPointers()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Maps D purity to LLVM memory attributes.
+void applyPurityAttrsToLLFunc(FuncDeclaration *fdecl, IrFuncTy &irFty,
+                              llvm::Function *func) {
+  // Constructors of immutable objects are strongly pure, but write to `this`.
+  if (fdecl->isCtorDeclaration() || fdecl->isPostBlitDeclaration() ||
+      fdecl->isDtorDeclaration() || fdecl->naked ||
+      fdecl->llvmInternal != LLVMnone) {
+    return;
+  }
+
+  const PURE purity = fdecl->isPure();
+  if (purity == PUREimpure) {
+    return;
+  }
+
+  auto tf = static_cast<TypeFunction *>(fdecl->type->toBasetype());
+  const bool hasContext = fdecl->needThis() || fdecl->isNested();
+
+  // A pure function whose arguments don't refer to mutable or const data can
+  // only return mutable memory it has allocated itself.
+  Type *rt = tf->next->toBasetype();
+  const bool returnsMutableRef =
+      (rt->ty == Tpointer && rt->nextOf()->isMutable()) ||
+      (rt->ty == Tclass && tf->next->isMutable());
+  if (returnsMutableRef && !tf->isref && !hasContext &&
+      hasOnlyImmutableIndirections(tf)) {
+    func->addAttribute(LLAttributeSet::ReturnIndex, LLAttribute::NoAlias);
+  }
+
+  // Strongly pure functions depend on nothing but their arguments and
+  // immutable data. Throwing functions are excluded, as are functions
+  // returning their result through an sret pointer, which they write to.
+  // Pure functions may allocate; that is only unobservable if the result
+  // cannot refer to the new memory, as merging two calls would otherwise
+  // merge two distinct allocations.
+  if (purity != PUREstrong || irFty.arg_sret || !DtoIsNothrow(fdecl) ||
+      returnsMutableRef || tf->isref || tf->next->hasPointers()) {
+    return;
+  }
+
+  bool readsArgMemory = hasContext || !hasNoIndirections(tf);
+  for (auto arg : irFty.args) {
+    readsArgMemory = readsArgMemory || arg->isByVal();
+  }
+  func->addFnAttr(readsArgMemory ? LLAttribute::ReadOnly
+                                 : LLAttribute::ReadNone);
+}
+
 /// Applies TargetMachine options as function attributes in the IR (options for
 /// which attributes exist).
 /// This is e.g. needed for LTO: it tells the linker/LTO-codegen what settings
@@ -556,6 +675,7 @@ void DtoDeclareFunction(FuncDeclaration *fdecl) {
   // parameter attributes
   if (!DtoIsIntrinsic(fdecl)) {
     applyParamAttrsToLLFunc(f, getIrFunc(fdecl)->irFty, func);
+    applyPurityAttrsToLLFunc(fdecl, getIrFunc(fdecl)->irFty, func);
     if (global.params.disableRedZone) {
       func->addFnAttr(LLAttribute::NoRedZone);
     }
@@ -580,7 +700,8 @@ void DtoDeclareFunction(FuncDeclaration *fdecl) {
   if (fdecl->neverInline) {
     irFunc->setNeverInline();
   } else {
-    if (fdecl->inlining == PINLINEalways) {
+    if (fdecl->inlining == PINLINEalways ||
+        (fdecl->isArrayOp && useInlineArrayOps())) {
       irFunc->setAlwaysInline();
     } else if (fdecl->inlining == PINLINEnever) {
       irFunc->setNeverInline();
@@ -686,7 +807,7 @@ static LinkageWithCOMDAT lowerFuncLinkage(FuncDeclaration *fdecl) {
 
   // Generated array op functions behave like templates in that they might be
   // emitted into many different modules.
-  if (fdecl->isArrayOp && (willInline() || !isDruntimeArrayOp(fdecl))) {
+  if (isInlineArrayOp(fdecl)) {
     return LinkageWithCOMDAT(templateLinkage, supportsCOMDAT());
   }
 
@@ -700,6 +821,44 @@ static LinkageWithCOMDAT lowerFuncLinkage(FuncDeclaration *fdecl) {
   return DtoLinkage(fdecl);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+/// The template instance functions defined in the object files of this
+/// invocation so far.
+llvm::StringSet<> definedTemplateInstances;
+
+/// Some template instances are defined in every module using them (e.g.,
+/// pragma(inline, true) functions and TypeInfo members of structs instantiated
+/// in non-root modules). If all object files of this invocation end up in the
+/// same binary or library, later modules can use the definitions emitted for
+/// earlier ones instead.
+bool isTemplateInstanceDedupEnabled() {
+  // linkonce_odr definitions might be discarded by the defining module.
+  return !disableTemplateInstanceDedup && !global.params.oneobj &&
+         global.params.output_o &&
+         (global.params.link || global.params.lib) &&
+         templateLinkage == LLGlobalValue::WeakODRLinkage &&
+         !gIR->dcomputetarget;
+}
+
+bool isTemplateInstanceDedupCandidate(FuncDeclaration *fd,
+                                      const LinkageWithCOMDAT &lwc) {
+  // Module ctors/dtors and unittests are registered with the current module.
+  return lwc.first == LLGlobalValue::WeakODRLinkage && !fd->naked &&
+         !fd->isUnitTestDeclaration() && !fd->isStaticCtorDeclaration() &&
+         !fd->isStaticDtorDeclaration() && isTemplateInstanceDedupEnabled();
+}
+
+/// Checks whether the given function has been defined by an earlier object
+/// file of this invocation.
+bool isDefinedInEarlierObject(FuncDeclaration *fd, llvm::Function *func) {
+  return func->isDeclaration() &&
+         isTemplateInstanceDedupCandidate(fd, lowerFuncLinkage(fd)) &&
+         definedTemplateInstances.count(func->getName());
+}
+} // anonymous namespace
+
 // LDC has the same problem with destructors of struct arguments in closures
 // as DMD, so we copy the failure detection
 void verifyScopedDestructionInClosure(FuncDeclaration *fd) {
@@ -791,7 +950,8 @@ void DtoDefineFunction(FuncDeclaration *fd, bool linkageAvailableExternally) {
     llvm::Function *func = getIrFunc(fd)->getLLVMFunc();
     assert(nullptr != func);
     if (!linkageAvailableExternally &&
-        (func->getLinkage() == llvm::GlobalValue::AvailableExternallyLinkage)) {
+        (func->getLinkage() == llvm::GlobalValue::AvailableExternallyLinkage) &&
+        !definedTemplateInstances.count(func->getName())) {
       // Fix linkage
       const auto lwc = lowerFuncLinkage(fd);
       setLinkage(lwc, func);
@@ -831,7 +991,7 @@ void DtoDefineFunction(FuncDeclaration *fd, bool linkageAvailableExternally) {
   }
 
   // Skip array ops implemented in druntime
-  if (fd->isArrayOp && !willInline() && isDruntimeArrayOp(fd)) {
+  if (fd->isArrayOp && !isInlineArrayOp(fd)) {
     IF_LOG Logger::println(
         "No code generation for array op %s implemented in druntime",
         fd->toChars());
@@ -866,6 +1026,19 @@ void DtoDefineFunction(FuncDeclaration *fd, bool linkageAvailableExternally) {
   }
   fd->ir->setDefined();
 
+  // A template instance defined by an earlier object file only needs to be
+  // declared, unless we want to be able to inline it.
+  if (!linkageAvailableExternally &&
+      isDefinedInEarlierObject(fd, getIrFunc(fd)->getLLVMFunc())) {
+    if (!willInline() && fd->inlining != PINLINEalways) {
+      IF_LOG Logger::println("Already defined in an earlier object file.");
+      return;
+    }
+    IF_LOG Logger::println("Already defined in an earlier object file, "
+                           "defining as available_externally.");
+    linkageAvailableExternally = true;
+  }
+
   // We cannot emit nested functions with parents that have not gone through
   // semantic analysis. This can happen as DMD leaks some template instances
   // from constraints into the module member list. DMD gets away with being
@@ -958,6 +1131,18 @@ void DtoDefineFunction(FuncDeclaration *fd, bool linkageAvailableExternally) {
            lwc.first != llvm::GlobalValue::LinkOnceAnyLinkage);
   } else {
     setLinkage(lwc, func);
+    if (isTemplateInstanceDedupCandidate(fd, lwc)) {
+      definedTemplateInstances.insert(func->getName());
+    }
+    // The address of a template instance is not unique anyway (e.g., across
+    // shared libraries), so allow identical instances to be folded.
+    if (opts::foldIdenticalCode && lwc.first == templateLinkage) {
+#if LDC_LLVM_VER >= 309
+      func->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+#else
+      func->setUnnamedAddr(true);
+#endif
+    }
   }
 
   assert(!func->hasDLLImportStorageClass());
@@ -1161,6 +1346,10 @@ void DtoDefineFunction(FuncDeclaration *fd, bool linkageAvailableExternally) {
     auto fn = gIR->module.getFunction(fd->mangleString);
     gIR->dcomputetarget->addKernelMetadata(fd, fn);
   }
+
+  if (!linkageAvailableExternally && hasTargetClonesUDA(fd)) {
+    gIR->targetClonedFunctions.push_back(fd);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1191,6 +1380,42 @@ DValue *DtoArgument(Parameter *fnarg, Expression *argexp) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool DtoIsNothrow(FuncDeclaration *fd) {
+  auto tf = static_cast<TypeFunction *>(fd->type->toBasetype());
+  if (tf->ty != Tfunction) {
+    return false;
+  }
+  if (tf->isnothrow) {
+    return true;
+  }
+
+  // The body is only available for analysis after semantic3; naked functions
+  // consist of inline asm only.
+  if (disableNothrowInference || !fd->fbody || fd->naked || fd->semantic3Errors ||
+      fd->semanticRun < PASSsemantic3done) {
+    return false;
+  }
+
+  IrFunction *irFunc = getIrFunc(fd, true);
+  if (irFunc->inferredNothrow < 0) {
+    // Same analysis as for the frontend's attribute inference (the body
+    // includes contracts and invariant calls). Warnings such as unreachable
+    // statements have already been reported by semantic3.
+    const unsigned errors = global.startGagging();
+    const int blockExit = statementBlockExit(fd->fbody, fd, false);
+    const bool failed = global.endGagging(errors);
+    irFunc->inferredNothrow = !failed && !(blockExit & BEthrow);
+
+    IF_LOG {
+      if (irFunc->inferredNothrow)
+        Logger::println("Inferred nothrow for %s", fd->toPrettyChars());
+    }
+  }
+  return irFunc->inferredNothrow != 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 int binary(const char *p, const char **tab, int high) {
   int i = 0, j = high, k, l;
   do {
@@ -1208,6 +1433,16 @@ int binary(const char *p, const char **tab, int high) {
   return -1;
 }
 
+bool useInlineArrayOps() {
+  if (inlineArrayOps != llvm::cl::BOU_UNSET)
+    return inlineArrayOps == llvm::cl::BOU_TRUE;
+  return willInline() || isOptimizationEnabled();
+}
+
+bool isInlineArrayOp(FuncDeclaration *fd) {
+  return fd->isArrayOp && (useInlineArrayOps() || !isDruntimeArrayOp(fd));
+}
+
 int isDruntimeArrayOp(FuncDeclaration *fd) {
   /* Some of the array op functions are written as library functions,
    * presumably to optimize them with special CPU vector instructions.
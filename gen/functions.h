@@ -44,7 +44,22 @@ void emitABIReturnAsmStmt(IRAsmBlock *asmblock, Loc &loc,
 
 DValue *DtoArgument(Parameter *fnarg, Expression *argexp);
 
+/// Returns whether calls to the given function can be treated like calls to a
+/// `nothrow` function, i.e., without landing pads. Besides the declared (or
+/// frontend-inferred) attribute, this analyzes the function body if available,
+/// as the frontend only infers attributes for templates, lambdas and auto
+/// functions.
+bool DtoIsNothrow(FuncDeclaration *fd);
+
 // Search for a druntime array op
 int isDruntimeArrayOp(FuncDeclaration *fd);
 
+/// Returns whether array operations are lowered to inline loops (marked for
+/// vectorization) instead of calling the druntime implementations.
+bool useInlineArrayOps();
+
+/// Returns whether the given array op function is to be emitted in the current
+/// module (instead of being resolved to its druntime implementation).
+bool isInlineArrayOp(FuncDeclaration *fd);
+
 #endif
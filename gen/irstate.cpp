@@ -18,7 +18,7 @@
 #include <cstdarg>
 
 IRState *gIR = nullptr;
-llvm::TargetMachine *gTargetMachine = nullptr;
+LLVM_THREAD_LOCAL llvm::TargetMachine *gTargetMachine = nullptr;
 const llvm::DataLayout *gDataLayout = nullptr;
 TargetABI *gABI = nullptr;
 
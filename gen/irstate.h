@@ -36,13 +36,16 @@ class TargetMachine;
 class IndexedInstrProfReader;
 }
 
+class CoverageMappingModuleGen;
 class FuncGenState;
 struct IRState;
 struct TargetABI;
 class DComputeTarget;
 
 extern IRState *gIR;
-extern llvm::TargetMachine *gTargetMachine;
+// Thread-local so that the DCompute targets can be emitted concurrently, each
+// with its own target machine.
+extern LLVM_THREAD_LOCAL llvm::TargetMachine *gTargetMachine;
 extern const llvm::DataLayout *gDataLayout;
 extern TargetABI *gABI;
 
@@ -188,6 +191,11 @@ public:
   std::unique_ptr<llvm::IndexedInstrProfReader> PGOReader;
   llvm::IndexedInstrProfReader *getPGOReader() const { return PGOReader.get(); }
 
+#if LDC_WITH_PGO && LDC_LLVM_VER >= 309
+  // Coverage mapping records of the module (-fcoverage-mapping)
+  std::unique_ptr<CoverageMappingModuleGen> CoverageMapping;
+#endif
+
   // for inline asm
   IRAsmBlock *asmBlock = nullptr;
   std::ostringstream nakedAsm;
@@ -196,6 +204,14 @@ public:
   // eliminated.
   std::vector<LLConstant *> usedArray;
 
+  // Functions defined with @ldc.attributes.targetClones, cloned when
+  // finalizing the module.
+  std::vector<FuncDeclaration *> targetClonedFunctions;
+
+  // Modules whose ModuleInfo has been emitted into this LLVM module (several
+  // for -singleobj).
+  std::vector<Module *> moduleInfos;
+
   /// Whether to emit array bounds checking in the current function.
   bool emitArrayBoundsChecks();
 
@@ -207,6 +223,10 @@ public:
   llvm::StringMap<llvm::GlobalVariable *> stringLiteral2ByteCache;
   llvm::StringMap<llvm::GlobalVariable *> stringLiteral4ByteCache;
 
+  // TBAA access tags, keyed by the name of the TBAA type (-enable-d-tbaa).
+  llvm::MDNode *tbaaOmnipotentChar = nullptr;
+  llvm::StringMap<llvm::MDNode *> tbaaAccessTags;
+
   // Sets the initializer for a global LL variable.
   // If the types don't match, this entails creating a new helper global
   // matching the initializer type and replacing all existing uses of globalVar
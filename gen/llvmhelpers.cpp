@@ -26,6 +26,7 @@
 #include "gen/mangling.h"
 #include "gen/pragma.h"
 #include "gen/runtime.h"
+#include "gen/tbaa.h"
 #include "gen/tollvm.h"
 #include "gen/typinf.h"
 #include "gen/uda.h"
@@ -46,11 +47,11 @@
 #include "llvm/Support/CommandLine.h"
 
 llvm::cl::opt<llvm::GlobalVariable::ThreadLocalMode> clThreadModel(
-    "fthread-model", llvm::cl::ZeroOrMore, llvm::cl::desc("Thread model"),
+    "fthread-model", llvm::cl::ZeroOrMore,
+    llvm::cl::desc("Thread model (default: strongest safe model per variable)"),
     llvm::cl::init(llvm::GlobalVariable::GeneralDynamicTLSModel),
     clEnumValues(clEnumValN(llvm::GlobalVariable::GeneralDynamicTLSModel,
-                            "global-dynamic",
-                            "Global dynamic TLS model (default)"),
+                            "global-dynamic", "Global dynamic TLS model"),
                  clEnumValN(llvm::GlobalVariable::LocalDynamicTLSModel,
                             "local-dynamic", "Local dynamic TLS model"),
                  clEnumValN(llvm::GlobalVariable::InitialExecTLSModel,
@@ -350,7 +351,7 @@ void DtoAssign(Loc &loc, DValue *lhs, DValue *rhs, int op,
       Logger::cout() << "r : " << *r << '\n';
     }
     r = DtoBitCast(r, l->getType()->getContainedType(0));
-    DtoStore(r, l);
+    addTBAAMetadata(gIR->ir->CreateStore(r, l), lhs);
   } else if (t->iscomplex()) {
     LLValue *dst = DtoLVal(lhs);
     LLValue *src = DtoRVal(DtoCast(loc, rhs, lhs->type));
@@ -380,7 +381,7 @@ void DtoAssign(Loc &loc, DValue *lhs, DValue *rhs, int op,
       assert(r->getType() == lit);
 #endif
     }
-    gIR->ir->CreateStore(r, l);
+    addTBAAMetadata(gIR->ir->CreateStore(r, l), lhs);
   }
 }
 
@@ -1702,19 +1703,54 @@ llvm::GlobalVariable *getOrCreateGlobal(const Loc &loc, llvm::Module &module,
     return existing;
   }
 
-  // Use a command line option for the thread model.
-  // On PPC there is only local-exec available - in this case just ignore the
-  // command line.
+  // The variable is treated as declared only; definitions are upgraded to a
+  // stronger model via setThreadLocalModeForDefinition().
   const llvm::GlobalVariable::ThreadLocalMode tlsModel =
-      isThreadLocal
-          ? (global.params.targetTriple->getArch() == llvm::Triple::ppc
-                 ? llvm::GlobalVariable::LocalExecTLSModel
-                 : clThreadModel.getValue())
-          : llvm::GlobalVariable::NotThreadLocal;
+      isThreadLocal ? getThreadLocalMode(/*isDefinition=*/false)
+                    : llvm::GlobalVariable::NotThreadLocal;
   return new llvm::GlobalVariable(module, type, isConstant, linkage, init, name,
                                   nullptr, tlsModel);
 }
 
+llvm::GlobalVariable::ThreadLocalMode getThreadLocalMode(bool isDefinition) {
+  // On PPC there is only local-exec available - in this case just ignore the
+  // command line.
+  if (global.params.targetTriple->getArch() == llvm::Triple::ppc) {
+    return llvm::GlobalVariable::LocalExecTLSModel;
+  }
+
+  // Use a command line option for the thread model if specified.
+  if (clThreadModel.getNumOccurrences() > 0) {
+    return clThreadModel.getValue();
+  }
+
+  // Otherwise select the strongest model that is known to be safe. If the
+  // object file ends up in an executable (we are linking one, or the code is
+  // not position-independent and thus cannot be part of a shared library),
+  // variables defined in it are at a fixed offset from the thread pointer, and
+  // all others are in the static TLS block of a library loaded at startup.
+  const auto relocModel = gTargetMachine->getRelocationModel();
+  const bool isPIC = relocModel == llvm::Reloc::PIC_
+#if LDC_LLVM_VER < 309
+                     || relocModel == llvm::Reloc::Default
+#endif
+      ;
+  const bool isExecutable =
+      (global.params.link && !global.params.dll && !global.params.lib) ||
+      !isPIC;
+  if (!isExecutable) {
+    return llvm::GlobalVariable::GeneralDynamicTLSModel;
+  }
+  return isDefinition ? llvm::GlobalVariable::LocalExecTLSModel
+                      : llvm::GlobalVariable::InitialExecTLSModel;
+}
+
+void setThreadLocalModeForDefinition(llvm::GlobalVariable *gvar) {
+  if (gvar->isThreadLocal()) {
+    gvar->setThreadLocalMode(getThreadLocalMode(/*isDefinition=*/true));
+  }
+}
+
 FuncDeclaration *getParentFunc(Dsymbol *sym) {
   if (!sym) {
     return nullptr;
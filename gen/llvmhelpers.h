@@ -256,6 +256,15 @@ llvm::GlobalVariable *getOrCreateGlobal(const Loc &loc, llvm::Module &module,
                                         llvm::StringRef name,
                                         bool isThreadLocal = false);
 
+/// Returns the TLS model for a thread-local variable declared or defined in the
+/// current module, as specified by -fthread-model or else automatically
+/// selected based on the output type.
+llvm::GlobalVariable::ThreadLocalMode getThreadLocalMode(bool isDefinition);
+
+/// Upgrades the TLS model of a thread-local variable defined in the current
+/// module (no-op for other variables).
+void setThreadLocalModeForDefinition(llvm::GlobalVariable *gvar);
+
 FuncDeclaration *getParentFunc(Dsymbol *sym);
 
 void Declaration_codegen(Dsymbol *decl);
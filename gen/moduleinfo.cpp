@@ -20,6 +20,9 @@
 #include "ir/irmodule.h"
 #include "ir/irtype.h"
 #include "module.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <functional>
 
 // These must match the values in druntime/src/object_.d
 #define MIstandalone 0x4
@@ -311,3 +314,171 @@ llvm::GlobalVariable *genModuleInfo(Module *m) {
   setLinkage({LLGlobalValue::ExternalLinkage, false}, moduleInfoSym);
   return moduleInfoSym;
 }
+
+namespace {
+/// The imported modules of m as seen by the runtime, i.e. the importedModules
+/// of its ModuleInfo (see buildImportedModules()).
+std::vector<Module *> runtimeImports(Module *m) {
+  std::vector<Module *> result;
+  for (auto mod : m->aimports) {
+    if (mod->needModuleInfo() && mod != m) {
+      result.push_back(mod);
+    }
+  }
+  return result;
+}
+
+/// Whether the ModuleInfo of m (emitted into the current object) refers to
+/// (shared or thread-local) module ctors or dtors.
+bool hasCtorsOrDtors(Module *m, bool shared) {
+  IrModule *irm = getIrModule(m);
+  if (shared) {
+    return !irm->sharedCtors.empty() || !irm->sharedGates.empty() ||
+           !irm->sharedDtors.empty();
+  }
+  return !irm->ctors.empty() || !irm->gates.empty() || !irm->dtors.empty();
+}
+
+/// Sorts the module ctors of the modules in a single object file the same way
+/// druntime's rt.minfo.sortCtors() does at program startup.
+class CtorOrderBuilder {
+public:
+  explicit CtorOrderBuilder(const std::vector<Module *> &modules)
+      : modules(modules), inObject(modules.begin(), modules.end()) {}
+
+  /// Returns false if an import path between two of our modules leads through
+  /// another module; its ctors would have to run in between, so the order can
+  /// only be determined by the runtime.
+  bool isSelfContained() const {
+    llvm::SmallPtrSet<Module *, 32> visited(modules.begin(), modules.end());
+    std::vector<Module *> worklist(modules.begin(), modules.end());
+    while (!worklist.empty()) {
+      Module *m = worklist.back();
+      worklist.pop_back();
+      for (auto imp : runtimeImports(m)) {
+        if (!inObject.count(m) && inObject.count(imp)) {
+          IF_LOG Logger::println("%s imports %s", m->toChars(), imp->toChars());
+          return false;
+        }
+        if (visited.insert(imp).second) {
+          worklist.push_back(imp);
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Orders the modules with (shared or thread-local) ctors/dtors after the
+  /// modules with ctors/dtors they import, directly or via modules without
+  /// any. Returns false for cyclic dependencies, which are left to the
+  /// runtime to report.
+  bool sort(bool shared, std::vector<Module *> &order) const {
+    enum State { Unvisited, InProgress, Done };
+    llvm::DenseMap<Module *, State> state;
+
+    std::function<bool(Module *)> visit = [&](Module *m) {
+      state[m] = InProgress;
+      for (auto dep : dependencies(m, shared)) {
+        const auto depState = state.lookup(dep);
+        if (depState == InProgress) {
+          IF_LOG Logger::println("cycle: %s -> %s", m->toChars(),
+                                 dep->toChars());
+          return false;
+        }
+        if (depState == Unvisited && !visit(dep)) {
+          return false;
+        }
+      }
+      state[m] = Done;
+      order.push_back(m);
+      return true;
+    };
+
+    for (auto m : modules) {
+      if (hasCtorsOrDtors(m, shared) && state.lookup(m) == Unvisited &&
+          !visit(m)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  /// The modules with relevant ctors/dtors whose ctors have to run before the
+  /// ones of m.
+  std::vector<Module *> dependencies(Module *m, bool shared) const {
+    std::vector<Module *> deps;
+    llvm::SmallPtrSet<Module *, 16> visited;
+    visited.insert(m);
+    std::vector<Module *> worklist = runtimeImports(m);
+    while (!worklist.empty()) {
+      Module *imp = worklist.back();
+      worklist.pop_back();
+      // Other modules don't import ours (see isSelfContained()).
+      if (!inObject.count(imp) || !visited.insert(imp).second) {
+        continue;
+      }
+      if (hasCtorsOrDtors(imp, shared)) {
+        deps.push_back(imp);
+      } else {
+        const auto imports = runtimeImports(imp);
+        worklist.insert(worklist.end(), imports.begin(), imports.end());
+      }
+    }
+    return deps;
+  }
+
+  const std::vector<Module *> &modules;
+  llvm::SmallPtrSet<Module *, 32> inObject;
+};
+}
+
+void emitModuleCtorOrder(IRState *irs) {
+  IF_LOG Logger::println("emitModuleCtorOrder()");
+  LOG_SCOPE;
+
+  assert(!gIR && "gIR not null, codegen already in progress?!");
+  gIR = irs;
+
+  const auto &modules = irs->moduleInfos;
+  CtorOrderBuilder builder(modules);
+  std::vector<Module *> ctors, tlsctors;
+  if (modules.empty() || !builder.isSelfContained() ||
+      !builder.sort(true, ctors) || !builder.sort(false, tlsctors)) {
+    IF_LOG Logger::println("leaving the ctor order to the runtime");
+    gIR = nullptr;
+    return;
+  }
+
+  const auto moduleInfoPtrTy = DtoPtrToType(Module::moduleinfo->type);
+  const auto buildArray = [&](const std::vector<Module *> &mods,
+                              const char *name) {
+    std::vector<LLConstant *> elements;
+    for (auto m : mods) {
+      elements.push_back(
+          DtoBitCast(getIrModule(m)->moduleInfoSymbol(), moduleInfoPtrTy));
+    }
+    const auto type = llvm::ArrayType::get(moduleInfoPtrTy, elements.size());
+    const auto array = new llvm::GlobalVariable(
+        irs->module, type, true, LLGlobalValue::InternalLinkage,
+        LLConstantArray::get(type, elements), name);
+    return DtoBitCast(array, getPtrToType(moduleInfoPtrTy));
+  };
+
+  LLConstant *fields[] = {
+      DtoConstSize_t(modules.size()),
+      buildArray(modules, "_d_moduleCtorOrder.modules"),
+      DtoConstSize_t(ctors.size()),
+      buildArray(ctors, "_d_moduleCtorOrder.ctors"),
+      DtoConstSize_t(tlsctors.size()),
+      buildArray(tlsctors, "_d_moduleCtorOrder.tlsctors")};
+  const auto init = LLConstantStruct::getAnon(fields);
+
+  // Strong, as only the object defining D main gets the table; linking
+  // several of them is an error.
+  new llvm::GlobalVariable(irs->module, init->getType(), true,
+                           LLGlobalValue::ExternalLinkage, init,
+                           "_d_moduleCtorOrder");
+
+  gIR = nullptr;
+}
@@ -11,6 +11,7 @@ namespace llvm {
 class GlobalVariable;
 }
 class Module;
+struct IRState;
 
 /// Creates a global variable containing the ModuleInfo data for the given
 /// module.
@@ -18,3 +19,21 @@ class Module;
 /// Note that this just creates data itself, and is not concerned with emitting
 /// a reference pointing to it to register the module with the runtime.
 llvm::GlobalVariable *genModuleInfo(Module *m);
+
+/// Emits the module constructor order of all modules whose ModuleInfo has been
+/// emitted into the given (-singleobj) LLVM module as `_d_moduleCtorOrder`, so
+/// that the runtime does not need to sort them at startup. Must only be called
+/// for the object defining D main, so that a program has at most one table:
+///
+///   struct {
+///     size_t numModules;  ModuleInfo** modules;  // all modules of the object
+///     size_t numCtors;    ModuleInfo** ctors;    // shared ctor/dtor order
+///     size_t numTlsCtors; ModuleInfo** tlsctors; // thread-local ctor order
+///   }
+///
+/// The order is only valid if no other module in the program is imported by
+/// one of these modules while importing another one (checked as far as the
+/// compiler knows the imports). The table is not emitted if this does not
+/// hold or if there are cyclic dependencies; the runtime then sorts the
+/// modules as usual.
+void emitModuleCtorOrder(IRState *irs);
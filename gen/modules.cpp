@@ -32,6 +32,7 @@
 #include "gen/mangling.h"
 #include "gen/moduleinfo.h"
 #include "gen/optimizer.h"
+#include "gen/pgo.h"
 #include "gen/runtime.h"
 #include "gen/structs.h"
 #include "gen/tollvm.h"
@@ -664,6 +665,7 @@ void loadInstrProfileData(IRState *irs) {
 void registerModuleInfo(Module *m) {
   const auto moduleInfoSym = genModuleInfo(m);
   const auto style = getModuleRegistryStyle();
+  gIR->moduleInfos.push_back(m);
 
   OutBuffer mangleBuf;
   mangleToBuffer(m, &mangleBuf);
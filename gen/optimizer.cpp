@@ -29,12 +29,14 @@
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/IR/LegacyPassNameParser.h"
 #include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
 
-extern llvm::TargetMachine *gTargetMachine;
+extern LLVM_THREAD_LOCAL llvm::TargetMachine *gTargetMachine;
 using namespace llvm;
 
 static cl::opt<signed char> optimizeLevel(
@@ -141,6 +143,13 @@ static inline void addPass(PassManagerBase &pm, Pass *pass) {
   }
 }
 
+static void addMergeFunctionsPass(const PassManagerBuilder &builder,
+                                  PassManagerBase &pm) {
+  if (builder.OptLevel >= 1) {
+    addPass(pm, createMergeFunctionsPass());
+  }
+}
+
 static void addStripExternalsPass(const PassManagerBuilder &builder,
                                   PassManagerBase &pm) {
   if (builder.OptLevel >= 1) {
@@ -191,6 +200,11 @@ static void addThreadSanitizerPass(const PassManagerBuilder &Builder,
   PM.add(createThreadSanitizerPass());
 }
 
+static void addAddDiscriminatorsPass(const PassManagerBuilder &Builder,
+                                     legacy::PassManagerBase &PM) {
+  PM.add(createAddDiscriminatorsPass());
+}
+
 static void addSanitizerCoveragePass(const PassManagerBuilder &Builder,
                                      legacy::PassManagerBase &PM) {
 #ifdef ENABLE_COVERAGE_SANITIZER
@@ -200,8 +214,56 @@ static void addSanitizerCoveragePass(const PassManagerBuilder &Builder,
 }
 
 // Adds PGO instrumentation generation and use passes.
-static void addPGOPasses(legacy::PassManagerBase &mpm, unsigned optLevel) {
+static void addPGOPasses(PassManagerBuilder &builder,
+                         legacy::PassManagerBase &mpm, unsigned optLevel) {
+  if (!opts::usefileSampleProf.empty()) {
+    // Sample profiles are attributed to source lines and discriminators, so
+    // add the discriminators as early as possible, before the profile is
+    // loaded.
+    builder.addExtension(PassManagerBuilder::EP_EarlyAsPossible,
+                         addAddDiscriminatorsPass);
+#if LDC_LLVM_VER >= 500
+    builder.PGOSampleUse = opts::usefileSampleProf;
+#else
+    mpm.add(createPruneEHPass());
+    mpm.add(createSampleProfileLoaderPass(opts::usefileSampleProf));
+#endif
+  }
+
 #if LDC_WITH_PGO
+#if LDC_LLVM_VER >= 309
+  if (opts::isGeneratingIRProf()) {
+    // We are generating IR-level PGO instrumented code. The counters are
+    // placed by LLVM after the early per-function simplifications, and lowered
+    // the same way as the frontend instrumentation.
+    mpm.add(createPGOInstrumentationGenLegacyPass());
+    InstrProfOptions options;
+    options.NoRedZone = global.params.disableRedZone;
+    if (!opts::genfileIRProf.empty()) {
+      llvm::SmallString<128> path(opts::genfileIRProf);
+      llvm::sys::path::append(path, "default_%m.profraw");
+      options.InstrProfileOutput = path.str();
+    }
+    mpm.add(createInstrProfilingLegacyPass(options));
+#if LDC_LLVM_VER >= 400
+    if (opts::continuousProfile) {
+      mpm.add(createProfileCounterRelocationPass());
+    }
+#endif
+    return;
+  }
+  if (opts::isUsingIRProf()) {
+    // We are generating code with IR-level PGO profile information available.
+    mpm.add(createPGOInstrumentationUseLegacyPass(opts::usefileIRProf));
+#if LDC_LLVM_VER >= 500
+    if (optLevel > 0) {
+      mpm.add(createPGOIndirectCallPromotionLegacyPass());
+    }
+#endif
+    return;
+  }
+#endif
+
   if (global.params.genInstrProf) {
     // We are generating PGO instrumented code.
     InstrProfOptions options;
@@ -212,6 +274,11 @@ static void addPGOPasses(legacy::PassManagerBase &mpm, unsigned optLevel) {
     mpm.add(createInstrProfilingLegacyPass(options));
 #else
     mpm.add(createInstrProfilingPass(options));
+#endif
+#if LDC_LLVM_VER >= 400
+    if (opts::continuousProfile) {
+      mpm.add(createProfileCounterRelocationPass());
+    }
 #endif
   } else if (global.params.datafileInstrProf) {
 // We are generating code with PGO profile information available.
@@ -320,11 +387,16 @@ static void addOptimizationPasses(legacy::PassManagerBase &mpm,
     }
   }
 
+  if (opts::foldIdenticalCode) {
+    builder.addExtension(PassManagerBuilder::EP_OptimizerLast,
+                         addMergeFunctionsPass);
+  }
+
   // EP_OptimizerLast does not exist in LLVM 3.0, add it manually below.
   builder.addExtension(PassManagerBuilder::EP_OptimizerLast,
                        addStripExternalsPass);
 
-  addPGOPasses(mpm, optLevel);
+  addPGOPasses(builder, mpm, optLevel);
 
   builder.populateFunctionPassManager(fpm);
   builder.populateModulePassManager(mpm);
@@ -414,6 +486,15 @@ void verifyModule(llvm::Module *m) {
   Logger::println("Verification passed!");
 }
 
+static void hashProfileFile(llvm::raw_ostream &hash_os,
+                            const std::string &filename) {
+  if (filename.empty())
+    return;
+  hash_os << filename;
+  if (auto buffer = MemoryBuffer::getFile(filename))
+    hash_os << (*buffer)->getBuffer();
+}
+
 // Output to `hash_os` all optimization settings that influence object code
 // output and that are not observable in the IR. This is used to calculate the
 // hash use for caching that uniquely identifies the object file output.
@@ -429,4 +510,15 @@ void outputOptimizationSettings(llvm::raw_ostream &hash_os) {
   hash_os << disableLoopUnrolling;
   hash_os << disableLoopVectorization;
   hash_os << disableSLPVectorization;
+
+  // The sample and IR-level profiles are applied during optimization, so they
+  // are not part of the IR: hash their contents.
+  hashProfileFile(hash_os, opts::usefileSampleProf);
+#if LDC_WITH_PGO && LDC_LLVM_VER >= 309
+  hash_os << opts::isGeneratingIRProf() << opts::genfileIRProf;
+  hashProfileFile(hash_os, opts::usefileIRProf);
+#endif
+#if LDC_WITH_PGO && LDC_LLVM_VER >= 400
+  hash_os << opts::continuousProfile;
+#endif
 }
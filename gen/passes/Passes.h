@@ -27,4 +27,9 @@ llvm::FunctionPass *createGarbageCollect2Stack();
 
 llvm::ModulePass *createStripExternalsPass();
 
+#if LDC_LLVM_VER >= 400
+// Redirects the lowered PGO counter accesses via a runtime bias.
+llvm::ModulePass *createProfileCounterRelocationPass();
+#endif
+
 #endif
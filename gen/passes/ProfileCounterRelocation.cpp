@@ -0,0 +1,133 @@
+//===-- ProfileCounterRelocation.cpp - Relocate PGO counters at runtime ---===//
+//
+//                         LDC – the LLVM D compiler
+//
+// This file is distributed under the BSD-style LDC license. See the LICENSE
+// file for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This transform rewrites all accesses to the PGO counters, as lowered by
+// LLVM's InstrProfiling pass, to go through a bias that is only known at
+// runtime:
+//   &__profc_foo[i]  ->  &__profc_foo[i] + __llvm_profile_counter_bias
+// This is used for the continuous profiling mode (-fprofile-continuous):
+// profile-rt maps the counters of the profile file into memory at startup and
+// sets the bias to redirect the counter updates to that mapping. If the
+// mapping cannot be set up, the bias stays 0 and the counters in the binary
+// are used as usual.
+// The module is tagged with __ldc_profile_continuous_mode, so that profile-rt
+// knows the counters can be relocated.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "profile-counter-relocation"
+
+#include "Passes.h"
+
+#if LDC_LLVM_VER >= 400
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ProfileData/InstrProf.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+STATISTIC(NumRelocated, "Number of counter accesses relocated");
+
+namespace {
+// Defined by profile-rt.
+const char *const BiasVarName = "__llvm_profile_counter_bias";
+// Defined here, referenced weakly by profile-rt.
+const char *const ContinuousModeVarName = "__ldc_profile_continuous_mode";
+
+struct LLVM_LIBRARY_VISIBILITY ProfileCounterRelocation : public ModulePass {
+  static char ID; // Pass identification, replacement for typeid
+  ProfileCounterRelocation() : ModulePass(ID) {}
+
+  // run - Do the ProfileCounterRelocation pass on the specified module.
+  //
+  bool runOnModule(Module &M) override;
+};
+}
+
+char ProfileCounterRelocation::ID = 0;
+static RegisterPass<ProfileCounterRelocation>
+    X("profile-counter-relocation",
+      "Relocate PGO counter accesses by a runtime bias");
+
+ModulePass *createProfileCounterRelocationPass() {
+  return new ProfileCounterRelocation();
+}
+
+// Collects the instruction operands referring to the counter array `V`. The
+// lowered counter increments address the array via constant GEPs, so look
+// through constant expressions. Other constant users (the profile data
+// records) must keep referring to the counters in the binary.
+static void collectCounterUses(Value *V, SmallVectorImpl<Use *> &uses) {
+  for (Use &U : V->uses()) {
+    User *user = U.getUser();
+    if (isa<Instruction>(user)) {
+      uses.push_back(&U);
+    } else if (isa<ConstantExpr>(user)) {
+      collectCounterUses(user, uses);
+    }
+  }
+}
+
+bool ProfileCounterRelocation::runOnModule(Module &M) {
+  SmallVector<Use *, 64> uses;
+  for (auto &GV : M.globals()) {
+    if (GV.getName().startswith(getInstrProfCountersVarPrefix())) {
+      collectCounterUses(&GV, uses);
+    }
+  }
+  if (uses.empty()) {
+    return false;
+  }
+
+  LLVMContext &context = M.getContext();
+  Type *intPtrTy = M.getDataLayout().getIntPtrType(context);
+  Constant *bias = M.getOrInsertGlobal(BiasVarName, intPtrTy);
+
+  if (!M.getNamedValue(ContinuousModeVarName)) {
+    auto marker = new GlobalVariable(
+        M, Type::getInt8Ty(context), true, GlobalValue::LinkOnceODRLinkage,
+        ConstantInt::get(Type::getInt8Ty(context), 1), ContinuousModeVarName);
+    marker->setVisibility(GlobalValue::HiddenVisibility);
+  }
+
+  // Load the bias once per function, at function entry.
+  DenseMap<Function *, Value *> functionBias;
+  for (Use *U : uses) {
+    auto I = cast<Instruction>(U->getUser());
+    Function *F = I->getFunction();
+    Value *&fnBias = functionBias[F];
+    if (!fnBias) {
+      IRBuilder<> builder(&*F->getEntryBlock().getFirstInsertionPt());
+      fnBias = builder.CreateLoad(bias, "profc.bias");
+    }
+
+    Instruction *insertPt = I;
+    if (auto phi = dyn_cast<PHINode>(I)) {
+      insertPt = phi->getIncomingBlock(*U)->getTerminator();
+    }
+    IRBuilder<> builder(insertPt);
+    Value *addr = builder.CreatePtrToInt(U->get(), intPtrTy);
+    addr = builder.CreateAdd(addr, fnBias);
+    DEBUG(errs() << "Relocating counter access: " << *I << '\n');
+    U->set(builder.CreateIntToPtr(addr, U->get()->getType()));
+    ++NumRelocated;
+  }
+
+  return true;
+}
+
+#endif // LDC_LLVM_VER >= 400
@@ -21,6 +21,7 @@
 #include "init.h"
 #include "statement.h"
 #include "llvm.h"
+#include "driver/cl_options.h"
 #include "gen/cl_helpers.h"
 #include "gen/irstate.h"
 #include "gen/logger.h"
@@ -28,8 +29,14 @@
 #include "gen/tollvm.h"
 
 #include "llvm/IR/Intrinsics.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/Triple.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/ProfileData/InstrProfReader.h"
+#if LDC_LLVM_VER >= 309
+#include "llvm/ProfileData/Coverage/CoverageMapping.h"
+#include "llvm/ProfileData/Coverage/CoverageMappingWriter.h"
+#endif
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MD5.h"
@@ -765,6 +772,457 @@ struct ComputeRegionCounts : public RecursiveVisitor {
   }
 };
 
+#if LDC_LLVM_VER >= 309
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+/// Returns the location where statement `S` ends, i.e. its closing curly
+/// bracket if the frontend recorded one, else the location of its last
+/// (sub)statement.
+static Loc getStatementEndLoc(Statement *S) {
+  struct EndLocVisitor : public Visitor {
+    Loc result;
+
+    using Visitor::visit;
+
+    void setEnd(Statement *s, const Loc &endloc) {
+      result = endloc.linnum ? endloc : s->loc;
+    }
+
+    void visit(Statement *s) override { result = s->loc; }
+    void visit(ScopeStatement *s) override { setEnd(s, s->endloc); }
+    void visit(WhileStatement *s) override { setEnd(s, s->endloc); }
+    void visit(DoStatement *s) override { setEnd(s, s->endloc); }
+    void visit(ForStatement *s) override { setEnd(s, s->endloc); }
+    void visit(ForeachStatement *s) override { setEnd(s, s->endloc); }
+    void visit(ForeachRangeStatement *s) override { setEnd(s, s->endloc); }
+    void visit(IfStatement *s) override { setEnd(s, s->endloc); }
+    void visit(WithStatement *s) override { setEnd(s, s->endloc); }
+
+    void visit(CompoundStatement *s) override {
+      result = s->loc;
+      for (size_t i = s->statements->dim; i-- > 0;) {
+        if (Statement *last = (*s->statements)[i]) {
+          last->accept(this);
+          return;
+        }
+      }
+    }
+
+    void visit(LabelStatement *s) override {
+      result = s->loc;
+      if (s->statement)
+        s->statement->accept(this);
+    }
+  };
+
+  EndLocVisitor v;
+  S->accept(&v);
+  return v.result;
+}
+
+/// An Recursive AST Visitor that builds the source regions of a function for
+/// the coverage mapping. The counters are propagated through the AST like
+/// ComputeRegionCounts propagates the counts, but as counter expressions
+/// that llvm-cov evaluates.
+/// Expressions only have a start location, so the operands of `&&`, `||`
+/// and `?:` take part in the counter propagation but don't get regions.
+struct CoverageMappingBuilder : public RecursiveVisitor {
+  using Counter = llvm::coverage::Counter;
+
+  /// The function being mapped; nested functions are mapped separately.
+  const FuncDeclaration *FD;
+
+  /// The map of statements to counters.
+  const llvm::DenseMap<const RootObject *, unsigned> &CounterMap;
+
+  llvm::coverage::CounterExpressionBuilder Builder;
+  std::vector<llvm::coverage::CounterMappingRegion> Regions;
+
+  /// A flag that is set when the current counter changed and a new region
+  /// should be started at the next statement, such as at the exit of a loop.
+  bool RecordNextStmtCount;
+
+  /// The counter at the current location in the traversal.
+  Counter CurrentCount;
+
+  /// The end of the innermost region, also used as the end of regions started
+  /// at a statement where the counter changed.
+  Loc RegionEnd;
+
+  /// BreakContinueStack - Keep counters of breaks and continues inside loops.
+  struct BreakContinue {
+    Counter BreakCount;
+    Counter ContinueCount;
+  };
+  llvm::SmallVector<BreakContinue, 8> BreakContinueStack;
+
+  struct LoopLabel {
+    // If a label is used as break/continue target, this struct stores the
+    // BreakContinue stack index at the label point
+    LabelStatement *label;
+    size_t stackindex;
+    LoopLabel(LabelStatement *_label, size_t index)
+        : label(_label), stackindex(index) {}
+  };
+  llvm::SmallVector<LoopLabel, 8> LoopLabels;
+
+  CoverageMappingBuilder(
+      const FuncDeclaration *FD,
+      const llvm::DenseMap<const RootObject *, unsigned> &CounterMap)
+      : FD(FD), CounterMap(CounterMap), RecordNextStmtCount(false) {}
+
+  Counter getRegionCounter(const RootObject *S) const {
+    auto it = CounterMap.find(S);
+    assert(it != CounterMap.end() && "Statement not found in PGO counter map!");
+    return Counter::getCounter(it->second);
+  }
+
+  Counter add(Counter LHS, Counter RHS) { return Builder.add(LHS, RHS); }
+  Counter subtract(Counter LHS, Counter RHS) {
+    return Builder.subtract(LHS, RHS);
+  }
+
+  /// Set and return the current counter.
+  Counter setCount(Counter Count) {
+    CurrentCount = Count;
+    return Count;
+  }
+
+  /// Add a region from `Start` up to and including `End`. Regions that do not
+  /// lie in the source file of the function (e.g. mixins) are skipped.
+  void addRegion(Counter Count, const Loc &Start, const Loc &End) {
+    const Loc &FuncLoc = FD->loc;
+    if (!Start.linnum || !Start.filename ||
+        strcmp(Start.filename, FuncLoc.filename) != 0) {
+      return;
+    }
+
+    unsigned LineStart = Start.linnum;
+    unsigned ColumnStart = Start.charnum ? Start.charnum : 1;
+    unsigned LineEnd = LineStart;
+    unsigned ColumnEnd = ColumnStart;
+    if (End.linnum && End.filename &&
+        strcmp(End.filename, FuncLoc.filename) == 0 &&
+        (End.linnum > LineStart ||
+         (End.linnum == LineStart && End.charnum >= ColumnStart))) {
+      LineEnd = End.linnum;
+      ColumnEnd = End.charnum ? End.charnum : 1;
+    }
+
+    // The end column is exclusive.
+    Regions.push_back(llvm::coverage::CounterMappingRegion::makeRegion(
+        Count, /*FileID=*/0, LineStart, ColumnStart, LineEnd, ColumnEnd + 1));
+  }
+
+  /// Add a region for statement `S` and visit it with counter `Count`.
+  void visitRegion(Statement *S, Counter Count, const Loc &End) {
+    setCount(Count);
+    RecordNextStmtCount = false;
+    if (!S)
+      return;
+
+    addRegion(Count, S->loc, End);
+    Loc SavedEnd = RegionEnd;
+    RegionEnd = End;
+    recurse(S);
+    RegionEnd = SavedEnd;
+  }
+
+  void visitRegion(Statement *S, Counter Count) {
+    visitRegion(S, Count, S ? getStatementEndLoc(S) : Loc());
+  }
+
+  using RecursiveVisitor::visit;
+
+  void visit(FuncDeclaration *fd) override {
+    if (fd != FD)
+      return;
+    // Counter tracks entry to the function body.
+    visitRegion(fd->fbody, getRegionCounter(fd->fbody), fd->endloc);
+  }
+
+  void visit(CompoundStatement *S) override {
+    for (auto s : *S->statements) {
+      if (!s)
+        continue;
+      if (RecordNextStmtCount) {
+        addRegion(CurrentCount, s->loc, RegionEnd);
+        RecordNextStmtCount = false;
+      }
+      recurse(s);
+    }
+  }
+
+  void visit(ReturnStatement *S) override {
+    recurse(S->exp);
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(ThrowStatement *S) override {
+    recurse(S->exp);
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(GotoStatement *S) override {
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(GotoDefaultStatement *S) override {
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(GotoCaseStatement *S) override {
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(LabelStatement *S) override {
+    RecordNextStmtCount = false;
+    // Counter tracks the block following the label.
+    addRegion(setCount(getRegionCounter(S)), S->loc, RegionEnd);
+    LoopLabels.push_back(LoopLabel(S, BreakContinueStack.size()));
+    recurse(S->statement);
+  }
+
+  BreakContinue &getBreakContinue(Statement *target) {
+    assert(!BreakContinueStack.empty() && "break/continue not in a loop!");
+    if (!target)
+      return BreakContinueStack.back();
+
+    auto it = std::find_if(
+        LoopLabels.begin(), LoopLabels.end(),
+        [target](const LoopLabel &LL) { return LL.label == target; });
+    assert(it != LoopLabels.end() && "It is not possible to break/continue to "
+                                     "a label that has not been visited yet");
+    assert(it->stackindex < BreakContinueStack.size());
+    return BreakContinueStack[it->stackindex];
+  }
+
+  void visit(BreakStatement *S) override {
+    BreakContinue &BC = getBreakContinue(S->target);
+    BC.BreakCount = add(BC.BreakCount, CurrentCount);
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(ContinueStatement *S) override {
+    BreakContinue &BC = getBreakContinue(S->target);
+    BC.ContinueCount = add(BC.ContinueCount, CurrentCount);
+    CurrentCount = Counter::getZero();
+    RecordNextStmtCount = true;
+  }
+
+  void visit(WhileStatement *S) override {
+    Counter ParentCount = CurrentCount;
+    BreakContinueStack.push_back(BreakContinue());
+    Counter BodyCount = getRegionCounter(S);
+    visitRegion(S->_body, BodyCount);
+    Counter BackedgeCount = CurrentCount;
+
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+    Counter CondCount =
+        setCount(add(ParentCount, add(BackedgeCount, BC.ContinueCount)));
+    recurse(S->condition);
+    setCount(add(BC.BreakCount, subtract(CondCount, BodyCount)));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(DoStatement *S) override {
+    Counter FallThroughCount = CurrentCount;
+    // The instr count includes the fallthrough from the parent scope.
+    BreakContinueStack.push_back(BreakContinue());
+    Counter BodyCount = getRegionCounter(S);
+    visitRegion(S->_body, BodyCount);
+    Counter BackedgeCount = CurrentCount;
+
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+    Counter CondCount = setCount(add(BackedgeCount, BC.ContinueCount));
+    recurse(S->condition);
+    Counter LoopCount = subtract(BodyCount, FallThroughCount);
+    setCount(add(BC.BreakCount, subtract(CondCount, LoopCount)));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(ForStatement *S) override {
+    recurse(S->_init);
+    Counter ParentCount = CurrentCount;
+
+    BreakContinueStack.push_back(BreakContinue());
+    Counter BodyCount = getRegionCounter(S);
+    visitRegion(S->_body, BodyCount);
+    Counter BackedgeCount = CurrentCount;
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+
+    if (S->increment) {
+      setCount(add(BackedgeCount, BC.ContinueCount));
+      recurse(S->increment);
+    }
+
+    Counter CondCount =
+        setCount(add(ParentCount, add(BackedgeCount, BC.ContinueCount)));
+    recurse(S->condition);
+    setCount(add(BC.BreakCount, subtract(CondCount, BodyCount)));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(ForeachStatement *S) override {
+    recurse(S->aggr);
+    Counter ParentCount = CurrentCount;
+
+    BreakContinueStack.push_back(BreakContinue());
+    Counter BodyCount = getRegionCounter(S);
+    visitRegion(S->_body, BodyCount);
+    Counter BackedgeCount = CurrentCount;
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+
+    Counter CondCount =
+        add(ParentCount, add(BackedgeCount, BC.ContinueCount));
+    setCount(add(BC.BreakCount, subtract(CondCount, BodyCount)));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(ForeachRangeStatement *S) override {
+    recurse(S->lwr);
+    recurse(S->upr);
+    Counter ParentCount = CurrentCount;
+
+    BreakContinueStack.push_back(BreakContinue());
+    Counter BodyCount = getRegionCounter(S);
+    visitRegion(S->_body, BodyCount);
+    Counter BackedgeCount = CurrentCount;
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+
+    Counter CondCount =
+        add(ParentCount, add(BackedgeCount, BC.ContinueCount));
+    setCount(add(BC.BreakCount, subtract(CondCount, BodyCount)));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(SwitchStatement *S) override {
+    recurse(S->condition);
+    CurrentCount = Counter::getZero();
+    BreakContinueStack.push_back(BreakContinue());
+    Loc SavedEnd = RegionEnd;
+    if (S->_body)
+      RegionEnd = getStatementEndLoc(S->_body);
+    recurse(S->_body);
+    RegionEnd = SavedEnd;
+    // If the switch is inside a loop, add the continue counts.
+    BreakContinue BC = BreakContinueStack.pop_back_val();
+    if (!BreakContinueStack.empty()) {
+      BreakContinueStack.back().ContinueCount =
+          add(BreakContinueStack.back().ContinueCount, BC.ContinueCount);
+    }
+    // Counter tracks the exit block of the switch.
+    setCount(getRegionCounter(S));
+    RecordNextStmtCount = true;
+  }
+
+  template <class CaseOrDefault> void visitCase(CaseOrDefault *S) {
+    // The case counter only counts jumps from the switch header; add the
+    // fallthrough from the case before. If this case is the target of a goto
+    // case, it has its own extra counter and behaves like a label.
+    Counter CaseCount =
+        S->gototarget ? getRegionCounter(CodeGenPGO::getCounterPtr(S, 1))
+                      : add(CurrentCount, getRegionCounter(S));
+    setCount(CaseCount);
+    RecordNextStmtCount = false;
+    Loc End = S->statement ? getStatementEndLoc(S->statement) : S->loc;
+    addRegion(CaseCount, S->loc, End);
+    Loc SavedEnd = RegionEnd;
+    RegionEnd = End;
+    recurse(S->statement);
+    RegionEnd = SavedEnd;
+  }
+
+  void visit(CaseStatement *S) override { visitCase(S); }
+  void visit(DefaultStatement *S) override { visitCase(S); }
+
+  void visit(IfStatement *S) override {
+    Counter ParentCount = CurrentCount;
+    recurse(S->condition);
+
+    // Counter tracks the "then" part of an if statement. The counter for
+    // the "else" part, if it exists, is calculated from this counter.
+    Counter ThenCount = getRegionCounter(S);
+    visitRegion(S->ifbody, ThenCount);
+    Counter OutCount = CurrentCount;
+
+    Counter ElseCount = subtract(ParentCount, ThenCount);
+    if (S->elsebody) {
+      visitRegion(S->elsebody, ElseCount);
+      OutCount = add(OutCount, CurrentCount);
+    } else {
+      OutCount = add(OutCount, ElseCount);
+    }
+    setCount(OutCount);
+    RecordNextStmtCount = true;
+  }
+
+  void visit(TryCatchStatement *S) override {
+    recurse(S->_body);
+    for (auto c : *S->catches) {
+      // Catch counter tracks the entry block of catch handler
+      visitRegion(c->handler, getRegionCounter(c));
+    }
+    // Try counter tracks the continuation block of the try statement.
+    setCount(getRegionCounter(S));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(TryFinallyStatement *S) override {
+    // No counters are mapped if there is nothing to "try" or no cleanup.
+    if (!S->_body || !S->finalbody) {
+      recurse(S->_body);
+      recurse(S->finalbody);
+      return;
+    }
+
+    Counter ParentCount = CurrentCount;
+    recurse(S->_body);
+    // Finally is always executed, so has same incoming counter as the parent
+    // counter of the try statement.
+    visitRegion(S->finalbody, ParentCount);
+    // The TryFinally counter tracks the continuation block of the try
+    // statement.
+    setCount(getRegionCounter(S));
+    RecordNextStmtCount = true;
+  }
+
+  void visit(CondExp *E) override {
+    Counter ParentCount = CurrentCount;
+    recurse(E->econd);
+    Counter TrueCount = setCount(getRegionCounter(E));
+    recurse(E->e1);
+    Counter OutCount = CurrentCount;
+    setCount(subtract(ParentCount, TrueCount));
+    recurse(E->e2);
+    setCount(add(OutCount, CurrentCount));
+  }
+
+  void visit(AndAndExp *E) override {
+    Counter ParentCount = CurrentCount;
+    recurse(E->e1);
+    Counter RHSCount = setCount(getRegionCounter(E));
+    recurse(E->e2);
+    setCount(subtract(add(ParentCount, RHSCount), CurrentCount));
+  }
+
+  void visit(OrOrExp *E) override {
+    Counter ParentCount = CurrentCount;
+    recurse(E->e1);
+    Counter RHSCount = setCount(getRegionCounter(E));
+    recurse(E->e2);
+    setCount(subtract(add(ParentCount, RHSCount), CurrentCount));
+  }
+};
+#endif // LDC_LLVM_VER >= 309
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -852,6 +1310,12 @@ void CodeGenPGO::assignRegionCounters(const FuncDeclaration *D,
   setFuncName(fn);
 
   mapRegionCounters(D);
+#if LDC_LLVM_VER >= 309
+  if (opts::coverageMapping && global.params.genInstrProf &&
+      emitInstrumentation) {
+    emitCounterRegionMapping(D);
+  }
+#endif
   if (PGOReader) {
     loadRegionCounts(PGOReader, D);
     computeRegionCounts(D);
@@ -877,6 +1341,162 @@ void CodeGenPGO::computeRegionCounts(const FuncDeclaration *FD) {
   Walker.visit(const_cast<FuncDeclaration *>(FD));
 }
 
+#if LDC_LLVM_VER >= 309
+void CodeGenPGO::emitCounterRegionMapping(const FuncDeclaration *D) {
+  if (!D->loc.filename || !D->fbody)
+    return;
+
+  CoverageMappingBuilder Builder(D, *RegionCounterMap);
+  Builder.visit(const_cast<FuncDeclaration *>(D));
+  if (Builder.Regions.empty())
+    return;
+
+  // The writer requires the regions to be sorted by their start location.
+  std::stable_sort(Builder.Regions.begin(), Builder.Regions.end(),
+                   [](const llvm::coverage::CounterMappingRegion &LHS,
+                      const llvm::coverage::CounterMappingRegion &RHS) {
+                     return LHS.startLoc() < RHS.startLoc();
+                   });
+
+  if (!gIR->CoverageMapping)
+    gIR->CoverageMapping.reset(new CoverageMappingModuleGen);
+  auto &ModuleGen = *gIR->CoverageMapping;
+
+  unsigned FileIDMapping[] = {ModuleGen.getFileID(D->loc.filename)};
+  std::string CoverageMapping;
+  llvm::raw_string_ostream OS(CoverageMapping);
+  llvm::coverage::CoverageMappingWriter(FileIDMapping,
+                                        Builder.Builder.getExpressions(),
+                                        Builder.Regions)
+      .write(OS);
+  OS.flush();
+
+  IF_LOG Logger::println("Coverage mapping for %s: %u regions",
+                         FuncName.c_str(),
+                         static_cast<unsigned>(Builder.Regions.size()));
+  ModuleGen.addFunctionMappingRecord(FuncName, FunctionHash, CoverageMapping);
+}
+
+unsigned CoverageMappingModuleGen::getFileID(llvm::StringRef Filename) {
+  llvm::SmallString<128> Path(Filename);
+  llvm::sys::fs::make_absolute(Path);
+  auto it = FileEntries.insert(
+      std::make_pair(Path.str(), static_cast<unsigned>(Filenames.size())));
+  if (it.second)
+    Filenames.push_back(Path.str());
+  return it.first->second;
+}
+
+void CoverageMappingModuleGen::addFunctionMappingRecord(
+    llvm::StringRef NameValue, uint64_t FuncHash,
+    const std::string &CoverageMapping) {
+  llvm::LLVMContext &Ctx = gIR->context();
+  if (!FunctionRecordTy) {
+#define COVMAP_FUNC_RECORD(Type, LLVMType, Name, Init) LLVMType,
+    llvm::Type *FunctionRecordTypes[] = {
+#include "llvm/ProfileData/InstrProfData.inc"
+    };
+    FunctionRecordTy =
+        llvm::StructType::get(Ctx, llvm::makeArrayRef(FunctionRecordTypes),
+                              /*isPacked=*/true);
+  }
+
+#define COVMAP_FUNC_RECORD(Type, LLVMType, Name, Init) Init,
+  llvm::Constant *FunctionRecordVals[] = {
+#include "llvm/ProfileData/InstrProfData.inc"
+  };
+  FunctionRecords.push_back(llvm::ConstantStruct::get(
+      FunctionRecordTy, llvm::makeArrayRef(FunctionRecordVals)));
+  CoverageMappings += CoverageMapping;
+}
+
+void CoverageMappingModuleGen::emit(IRState &irs) {
+  using namespace llvm::coverage;
+
+  if (FunctionRecords.empty())
+    return;
+
+  llvm::Module &M = irs.module;
+  llvm::LLVMContext &Ctx = M.getContext();
+  auto *Int32Ty = llvm::Type::getInt32Ty(Ctx);
+
+  // Create the filenames and merge them with the coverage mappings.
+  std::string FilenamesAndCoverageMappings;
+  llvm::raw_string_ostream OS(FilenamesAndCoverageMappings);
+  std::vector<llvm::StringRef> FilenameRefs(Filenames.begin(),
+                                            Filenames.end());
+  CoverageFilenamesSectionWriter(FilenameRefs).write(OS);
+  size_t FilenamesSize = OS.str().size();
+  size_t CoverageMappingSize = CoverageMappings.size();
+  OS << CoverageMappings;
+  // Append extra zeroes if necessary to ensure that the size of the filenames
+  // and coverage mappings is a multiple of 8.
+  if (size_t Rem = OS.str().size() % 8) {
+    CoverageMappingSize += 8 - Rem;
+    for (size_t I = 0, S = 8 - Rem; I < S; ++I)
+      OS << '\0';
+  }
+  auto *FilenamesAndMappingsVal =
+      llvm::ConstantDataArray::getString(Ctx, OS.str(), false);
+
+  auto *RecordsTy =
+      llvm::ArrayType::get(FunctionRecordTy, FunctionRecords.size());
+  auto *RecordsVal = llvm::ConstantArray::get(RecordsTy, FunctionRecords);
+
+#define COVMAP_HEADER(Type, LLVMType, Name, Init) LLVMType,
+  llvm::Type *CovDataHeaderTypes[] = {
+#include "llvm/ProfileData/InstrProfData.inc"
+  };
+  auto *CovDataHeaderTy =
+      llvm::StructType::get(Ctx, llvm::makeArrayRef(CovDataHeaderTypes));
+#define COVMAP_HEADER(Type, LLVMType, Name, Init) Init,
+  llvm::Constant *CovDataHeaderVals[] = {
+#include "llvm/ProfileData/InstrProfData.inc"
+  };
+  auto *CovDataHeaderVal = llvm::ConstantStruct::get(
+      CovDataHeaderTy, llvm::makeArrayRef(CovDataHeaderVals));
+
+  llvm::Type *CovDataTypes[] = {CovDataHeaderTy, RecordsTy,
+                                FilenamesAndMappingsVal->getType()};
+  auto *CovDataTy =
+      llvm::StructType::get(Ctx, llvm::makeArrayRef(CovDataTypes));
+  llvm::Constant *CovDataVals[] = {CovDataHeaderVal, RecordsVal,
+                                   FilenamesAndMappingsVal};
+  auto *CovData = new llvm::GlobalVariable(
+      M, CovDataTy, true, llvm::GlobalValue::InternalLinkage,
+      llvm::ConstantStruct::get(CovDataTy, llvm::makeArrayRef(CovDataVals)),
+      llvm::getCoverageMappingVarName());
+
+#if LDC_LLVM_VER >= 500
+  CovData->setSection(llvm::getInstrProfSectionName(
+      llvm::IPSK_covmap, llvm::Triple(M.getTargetTriple()).getObjectFormat()));
+#elif LDC_LLVM_VER >= 400
+  CovData->setSection(llvm::getInstrProfCoverageSectionName(&M));
+#else
+  CovData->setSection(llvm::getInstrProfCoverageSectionName(
+      llvm::Triple(M.getTargetTriple()).isOSBinFormatMachO()));
+#endif
+  CovData->setAlignment(8);
+
+  // Make sure the data doesn't get deleted.
+  irs.usedArray.push_back(CovData);
+}
+#endif
+
+namespace {
+#if LDC_LLVM_VER >= 400
+/// Returns the minimum count of the hottest counters that together make up
+/// `Cutoff` (in millionths) of the total count of the profile.
+uint64_t getCountThreshold(llvm::ProfileSummary &Summary, uint32_t Cutoff) {
+  for (const auto &Entry : Summary.getDetailedSummary()) {
+    if (Entry.Cutoff >= Cutoff)
+      return Entry.MinCount;
+  }
+  return 0;
+}
+#endif
+}
+
 /// Apply attributes to llvm::Function based on profiling data.
 void CodeGenPGO::applyFunctionAttributes(llvm::Function *Fn) {
   if (!haveRegionCounts())
@@ -884,6 +1504,84 @@ void CodeGenPGO::applyFunctionAttributes(llvm::Function *Fn) {
 
   uint64_t FunctionCount = getRegionCount(nullptr);
   Fn->setEntryCount(FunctionCount);
+
+#if LDC_LLVM_VER >= 400
+  // Place hot and cold functions in separate sections (.text.hot and
+  // .text.unlikely), using the same cutoffs as LLVM's ProfileSummaryInfo.
+  llvm::ProfileSummary &Summary = gIR->getPGOReader()->getSummary();
+  if (FunctionCount && FunctionCount >= getCountThreshold(Summary, 990000)) {
+    Fn->setSectionPrefix(".hot");
+  } else if (FunctionCount <= getCountThreshold(Summary, 999999)) {
+    Fn->setSectionPrefix(".unlikely");
+  }
+#endif
+}
+
+bool writeSymbolOrderingFile(const std::string &Filename,
+                             bool UseSectionNames) {
+  // Take the functions from the whole profile, not just the ones generated by
+  // this invocation, so that the file is the same for all compilations using
+  // the profile.
+  std::vector<std::pair<std::string, uint64_t>> ProfiledFunctions;
+  if (!global.params.genInstrProf && global.params.datafileInstrProf) {
+    auto ReaderOrErr =
+        llvm::IndexedInstrProfReader::create(global.params.datafileInstrProf);
+#if LDC_LLVM_VER >= 309
+    if (auto E = ReaderOrErr.takeError()) {
+      handleAllErrors(std::move(E), [&](const llvm::ErrorInfoBase &EI) {
+        error(Loc(), "Could not read profile file '%s': %s",
+              global.params.datafileInstrProf, EI.message().c_str());
+      });
+      return false;
+    }
+#else
+    if (std::error_code EC = ReaderOrErr.getError()) {
+      error(Loc(), "Could not read profile file '%s': %s",
+            global.params.datafileInstrProf, EC.message().c_str());
+      return false;
+    }
+#endif
+
+    for (const auto &Record : *ReaderOrErr.get()) {
+      // The first counter is the function entry count.
+      if (Record.Counts.empty() || !Record.Counts[0])
+        continue;
+      // Functions with local linkage are prefixed by their source file.
+      llvm::StringRef Name = Record.Name;
+      const size_t Sep = Name.rfind(':');
+      if (Sep != llvm::StringRef::npos)
+        Name = Name.substr(Sep + 1);
+      ProfiledFunctions.emplace_back(Name.str(), Record.Counts[0]);
+    }
+  }
+
+  // Hottest functions first; a function may have several records (e.g. with
+  // different hashes), so only keep the first (hottest) occurrence.
+  std::stable_sort(ProfiledFunctions.begin(), ProfiledFunctions.end(),
+                   [](const std::pair<std::string, uint64_t> &LHS,
+                      const std::pair<std::string, uint64_t> &RHS) {
+                     return LHS.second > RHS.second;
+                   });
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Filename, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    error(Loc(), "Could not write symbol ordering file '%s': %s",
+          Filename.c_str(), EC.message().c_str());
+    return false;
+  }
+
+  llvm::StringSet<> Written;
+  for (const auto &F : ProfiledFunctions) {
+    if (!Written.insert(F.first).second)
+      continue;
+    // With -function-sections, a function `f` ends up in section `.text.f`,
+    // `.text.hot.f` or `.text.unlikely.f`.
+    if (UseSectionNames)
+      OS << ".text*.";
+    OS << F.first << '\n';
+  }
+  return true;
 }
 
 void CodeGenPGO::emitCounterIncrement(const RootObject *S) const {
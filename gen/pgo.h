@@ -19,6 +19,7 @@
 #define LDC_GEN_PGO_H
 
 #include "gen/llvm.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ProfileData/InstrProf.h"
 #include <string>
 #include <vector>
@@ -90,6 +91,32 @@ public:
 
 #else
 
+#if LDC_LLVM_VER >= 309
+/// Collects the coverage mapping records of the instrumented functions of a
+/// module and emits them as the module's coverage mapping data
+/// (-fcoverage-mapping), to be read by llvm-cov.
+class CoverageMappingModuleGen {
+public:
+  /// Return the index of `Filename` in the filenames table of the module.
+  unsigned getFileID(llvm::StringRef Filename);
+
+  /// Add the encoded coverage mapping of a function.
+  void addFunctionMappingRecord(llvm::StringRef FuncName, uint64_t FuncHash,
+                                const std::string &CoverageMapping);
+
+  /// Emit the coverage mapping data of all added functions into the LLVM
+  /// module of `irs`.
+  void emit(IRState &irs);
+
+private:
+  llvm::StringMap<unsigned> FileEntries;
+  std::vector<std::string> Filenames;
+  llvm::StructType *FunctionRecordTy = nullptr;
+  std::vector<llvm::Constant *> FunctionRecords;
+  std::string CoverageMappings;
+};
+#endif
+
 /// Keeps per-function PGO state.
 class CodeGenPGO {
 public:
@@ -231,11 +258,21 @@ private:
 #endif
   void mapRegionCounters(const FuncDeclaration *D);
   void computeRegionCounts(const FuncDeclaration *D);
+#if LDC_LLVM_VER >= 309
+  void emitCounterRegionMapping(const FuncDeclaration *D);
+#endif
   void applyFunctionAttributes(llvm::Function *Fn);
   void loadRegionCounts(llvm::IndexedInstrProfReader *PGOReader,
                         const FuncDeclaration *D);
 };
 
+/// Writes the names of all functions executed according to the
+/// -fprofile-instr-use profile to `Filename`, hottest first, as linker symbol
+/// ordering file. For gold, section name patterns are written instead of
+/// symbol names.
+bool writeSymbolOrderingFile(const std::string &Filename,
+                             bool UseSectionNames);
+
 #endif // LLVM version
 
 #endif //  LDC_GEN_PGO_H
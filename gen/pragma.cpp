@@ -17,6 +17,8 @@
 #include "template.h"
 #include "gen/llvmhelpers.h"
 #include "llvm/Support/CommandLine.h"
+#include <cstdint>
+#include <cstring>
 
 static bool parseStringExp(Expression *e, const char *&res) {
   e = e->optimize(WANTvalue);
@@ -539,3 +541,133 @@ bool DtoIsVaIntrinsic(FuncDeclaration *fd) {
 bool DtoCheckProfileInstrPragma(Expression *arg, bool &value) {
   return parseBoolExp(arg, value);
 }
+
+namespace {
+enum class LoopHintValue { Bool, Count, Unroll };
+
+struct LoopHint {
+  const char *name;
+  LoopHintValue value;
+  const char *metadata; // `llvm.loop` hint name, unused for Unroll.
+};
+
+// The hints accepted by pragma(LDC_loop, ...), modelled after clang's
+// `#pragma clang loop`.
+const LoopHint loopHints[] = {
+    {"vectorize", LoopHintValue::Bool, "llvm.loop.vectorize.enable"},
+    {"vectorize_width", LoopHintValue::Count, "llvm.loop.vectorize.width"},
+    {"interleave_count", LoopHintValue::Count, "llvm.loop.interleave.count"},
+    {"unroll", LoopHintValue::Unroll, nullptr},
+    {"unroll_count", LoopHintValue::Count, "llvm.loop.unroll.count"},
+    {"distribute", LoopHintValue::Bool, "llvm.loop.distribute.enable"},
+};
+}
+
+// pragma(LDC_loop, "hint", value, ...)
+// Checks the hint/value pairs and, if `hints` is given, appends the
+// corresponding `llvm.loop` metadata to it.
+// Return false if an error occurred.
+static bool parseLoopHints(Expressions *args, llvm::LLVMContext *ctx,
+                           llvm::SmallVectorImpl<llvm::Metadata *> *hints) {
+  if (args->dim % 2 != 0) {
+    Expression *last = (*args)[args->dim - 1];
+    error(last->loc, "value expected for loop hint `%s`", last->toChars());
+    return false;
+  }
+
+  for (size_t i = 0; i < args->dim; i += 2) {
+    Expression *nameExp = (*args)[i];
+    Expression *valueExp = (*args)[i + 1];
+
+    const char *name = nullptr;
+    if (!parseStringExp(nameExp, name)) {
+      error(nameExp->loc, "loop hint name expected, not `%s`",
+            nameExp->toChars());
+      return false;
+    }
+
+    const LoopHint *hint = nullptr;
+    for (const auto &h : loopHints) {
+      if (strcmp(h.name, name) == 0) {
+        hint = &h;
+        break;
+      }
+    }
+    if (!hint) {
+      error(nameExp->loc,
+            "unknown loop hint `%s`, expected `vectorize`, `vectorize_width`, "
+            "`interleave_count`, `unroll`, `unroll_count` or `distribute`",
+            name);
+      return false;
+    }
+
+    const char *mdName = hint->metadata;
+    llvm::Metadata *mdValue = nullptr;
+    bool b = false;
+    dinteger_t n = 0;
+    const char *s = nullptr;
+    switch (hint->value) {
+    case LoopHintValue::Bool:
+      if (!parseBoolExp(valueExp, b)) {
+        error(valueExp->loc,
+              "loop hint `%s` expects `true` or `false`, not `%s`", name,
+              valueExp->toChars());
+        return false;
+      }
+      if (ctx) {
+        mdValue = llvm::ConstantAsMetadata::get(
+            llvm::ConstantInt::get(llvm::Type::getInt1Ty(*ctx), b));
+      }
+      break;
+
+    case LoopHintValue::Count:
+      if (!parseIntExp(valueExp, n) || n == 0 || n > INT32_MAX) {
+        error(valueExp->loc,
+              "loop hint `%s` expects a positive integer, not `%s`", name,
+              valueExp->toChars());
+        return false;
+      }
+      if (ctx) {
+        mdValue = llvm::ConstantAsMetadata::get(
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(*ctx), n));
+      }
+      break;
+
+    case LoopHintValue::Unroll:
+      if (parseBoolExp(valueExp, b)) {
+        mdName = b ? "llvm.loop.unroll.enable" : "llvm.loop.unroll.disable";
+      } else if (parseStringExp(valueExp, s) && strcmp(s, "full") == 0) {
+        mdName = "llvm.loop.unroll.full";
+      } else {
+        error(valueExp->loc,
+              "loop hint `unroll` expects `true`, `false` or `\"full\"`, not "
+              "`%s`",
+              valueExp->toChars());
+        return false;
+      }
+      break;
+    }
+
+    if (hints) {
+      llvm::Metadata *mdString = llvm::MDString::get(*ctx, mdName);
+      if (mdValue) {
+        hints->push_back(llvm::MDNode::get(*ctx, {mdString, mdValue}));
+      } else {
+        hints->push_back(llvm::MDNode::get(*ctx, mdString));
+      }
+    }
+  }
+
+  return true;
+}
+
+bool DtoCheckLoopPragma(Expressions *args) {
+  return parseLoopHints(args, nullptr, nullptr);
+}
+
+void DtoGetLoopPragmaHints(Expressions *args, llvm::LLVMContext &ctx,
+                           llvm::SmallVectorImpl<llvm::Metadata *> &hints) {
+  const bool ok = parseLoopHints(args, &ctx, &hints);
+  assert(ok && "loop hints should have been checked during semantic");
+  (void)ok;
+}
@@ -21,6 +21,14 @@ class FuncDeclaration;
 class Dsymbol;
 struct Scope;
 class Expression;
+template <typename TYPE> struct Array;
+typedef Array<class Expression *> Expressions;
+
+namespace llvm {
+class LLVMContext;
+class Metadata;
+template <typename T> class SmallVectorImpl;
+}
 
 // Remember to keep this enum in-sync with dpragma.d
 enum LDCPragma {
@@ -56,6 +64,9 @@ LDCPragma DtoGetPragma(Scope *sc, PragmaDeclaration *decl, const char *&arg1str)
 void DtoCheckPragma(PragmaDeclaration *decl, Dsymbol *sym, LDCPragma llvm_internal,
                     const char * const arg1str);
 bool DtoCheckProfileInstrPragma(Expression *arg, bool &value);
+bool DtoCheckLoopPragma(Expressions *args);
+void DtoGetLoopPragmaHints(Expressions *args, llvm::LLVMContext &ctx,
+                           llvm::SmallVectorImpl<llvm::Metadata *> &hints);
 bool DtoIsIntrinsic(FuncDeclaration *fd);
 bool DtoIsVaIntrinsic(FuncDeclaration *fd);
 
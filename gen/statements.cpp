@@ -19,10 +19,12 @@
 #include "gen/dcompute/target.h"
 #include "gen/dvalue.h"
 #include "gen/funcgenstate.h"
+#include "gen/functions.h"
 #include "gen/irstate.h"
 #include "gen/llvm.h"
 #include "gen/llvmhelpers.h"
 #include "gen/logger.h"
+#include "gen/pragma.h"
 #include "gen/runtime.h"
 #include "gen/tollvm.h"
 #include "id.h"
@@ -86,6 +88,46 @@ static LLValue *call_string_switch_runtime(llvm::Value *table, Expression *e) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+/// Attaches a distinct `llvm.loop` metadata node with the given hints to the
+/// branch instruction jumping back to the loop header.
+static void addLoopMetadata(llvm::Instruction *latch,
+                            llvm::ArrayRef<llvm::Metadata *> hints) {
+  if (hints.empty()) {
+    return;
+  }
+
+  auto &ctx = latch->getContext();
+
+  // The first operand of a loop ID is a self-reference.
+  llvm::SmallVector<llvm::Metadata *, 4> ops;
+  auto tempNode = llvm::MDNode::getTemporary(ctx, llvm::None);
+  ops.push_back(tempNode.get());
+  ops.append(hints.begin(), hints.end());
+
+  llvm::MDNode *loopID = llvm::MDNode::get(ctx, ops);
+  loopID->replaceOperandWith(0, loopID);
+  latch->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+}
+
+/// Returns the loop hints for the loops of compiler-generated array operation
+/// functions when these are lowered inline: force-enable vectorization, so
+/// that the loops are vectorized (with runtime aliasing checks) for the
+/// selected CPU even with -O1.
+static void getArrayOpLoopHints(IRState *irs,
+                                llvm::SmallVectorImpl<llvm::Metadata *> &hints) {
+  FuncDeclaration *fd = irs->func()->decl;
+  if (!fd->isArrayOp || !useInlineArrayOps()) {
+    return;
+  }
+
+  auto &ctx = irs->context();
+  hints.push_back(llvm::MDNode::get(
+      ctx, {llvm::MDString::get(ctx, "llvm.loop.vectorize.enable"),
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::getTrue(ctx))}));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 class ToIRVisitor : public Visitor {
   IRState *irs;
 
@@ -544,6 +586,11 @@ public:
           PGO.createProfileWeightsWhileLoop(stmt->condition, loopcount);
       PGO.addBranchWeights(branchinst, brweights);
     }
+    if (stmt->loopHints) {
+      llvm::SmallVector<llvm::Metadata *, 4> hints;
+      DtoGetLoopPragmaHints(stmt->loopHints, irs->context(), hints);
+      addLoopMetadata(branchinst, hints);
+    }
 
     // rewrite the scope
     irs->scope() = IRScope(endbb);
@@ -635,7 +682,13 @@ public:
 
     // loop
     if (!irs->scopereturned()) {
-      llvm::BranchInst::Create(forbb, irs->scopebb());
+      auto latch = llvm::BranchInst::Create(forbb, irs->scopebb());
+      llvm::SmallVector<llvm::Metadata *, 4> hints;
+      if (stmt->loopHints) {
+        DtoGetLoopPragmaHints(stmt->loopHints, irs->context(), hints);
+      }
+      getArrayOpLoopHints(irs, hints);
+      addLoopMetadata(latch, hints);
     }
 
     irs->funcGen().jumpTargets.popLoopTarget();
@@ -1486,7 +1539,12 @@ public:
     }
 
     // jump to condition
-    llvm::BranchInst::Create(condbb, irs->scopebb());
+    auto latch = llvm::BranchInst::Create(condbb, irs->scopebb());
+    {
+      llvm::SmallVector<llvm::Metadata *, 4> hints;
+      getArrayOpLoopHints(irs, hints);
+      addLoopMetadata(latch, hints);
+    }
 
     // end the dwarf lexical block
     irs->DBuilder.EmitBlockEnd();
@@ -0,0 +1,245 @@
+//===-- tbaa.cpp ----------------------------------------------------------===//
+//
+//                         LDC – the LLVM D compiler
+//
+// This file is distributed under the BSD-style LDC license. See the LICENSE
+// file for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The D TBAA type tree is flat: all scalar types are children of an
+// 'omnipotent char' node, which is used for all character and byte types as
+// well as void and thus aliases everything. Signed and unsigned integers of
+// the same size share a node, as do all pointers and class references.
+// Aggregates (structs, slices, delegates, vectors, complex numbers) are never
+// tagged.
+//
+// D has no strict aliasing rule, and reinterpreting memory through pointer
+// variables is common (and not detectable here), so the metadata is only
+// emitted with -enable-d-tbaa.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gen/tbaa.h"
+
+#include "declaration.h"
+#include "expression.h"
+#include "mtype.h"
+#include "gen/dvalue.h"
+#include "gen/irstate.h"
+#include "gen/optimizer.h"
+#include "gen/tollvm.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/Support/CommandLine.h"
+
+namespace cl = llvm::cl;
+
+static cl::opt<bool> enableDTBAA(
+    "enable-d-tbaa", cl::ZeroOrMore,
+    cl::desc("Emit D type-based alias analysis metadata, assuming that memory "
+             "is never accessed through pointers to unrelated types"));
+
+namespace {
+
+const char *const omnipotentCharName = "omnipotent char";
+
+/// Returns the name of the TBAA scalar type for the given D type, or null if
+/// accesses of that type aren't tagged.
+const char *getTBAATypeName(Type *t) {
+  Type *bt = t->toBasetype();
+  switch (bt->ty) {
+  case Tvoid:
+  case Tbool:
+  case Tint8:
+  case Tuns8:
+  case Tchar:
+  case Twchar:
+  case Tdchar:
+    return omnipotentCharName;
+  case Tint16:
+  case Tuns16:
+    return "short";
+  case Tint32:
+  case Tuns32:
+    return "int";
+  case Tint64:
+  case Tuns64:
+    return "long";
+  case Tint128:
+  case Tuns128:
+    return "cent";
+  case Tfloat32:
+  case Tfloat64:
+  case Tfloat80:
+  case Timaginary32:
+  case Timaginary64:
+  case Timaginary80: {
+    // Key by the LLVM type, as real may be a plain double on some targets.
+    LLType *llType = DtoType(bt);
+    return llType->isFloatTy() ? "float"
+                               : llType->isDoubleTy() ? "double" : "real";
+  }
+  case Tpointer:
+  case Tclass:
+  case Taarray:
+    return "any pointer";
+  default:
+    return nullptr;
+  }
+}
+
+/// Returns the (cached) access tag for the TBAA scalar type with the given
+/// name.
+llvm::MDNode *getTBAAAccessTag(const char *name) {
+  llvm::MDNode *&tag = gIR->tbaaAccessTags[name];
+  if (tag) {
+    return tag;
+  }
+
+  llvm::MDBuilder mdb(gIR->context());
+  if (!gIR->tbaaOmnipotentChar) {
+    gIR->tbaaOmnipotentChar = mdb.createTBAAScalarTypeNode(
+        omnipotentCharName, mdb.createTBAARoot("LDC D TBAA"));
+  }
+  llvm::MDNode *type =
+      name == omnipotentCharName
+          ? gIR->tbaaOmnipotentChar
+          : mdb.createTBAAScalarTypeNode(name, gIR->tbaaOmnipotentChar);
+  tag = mdb.createTBAAStructTagNode(type, type, 0);
+  return tag;
+}
+
+Type *stripStaticArrays(Type *t) {
+  t = t->toBasetype();
+  while (t->ty == Tsarray) {
+    t = t->nextOf()->toBasetype();
+  }
+  return t;
+}
+
+/// Returns true if accessing memory of type `from` as type `to` might violate
+/// the TBAA type tree.
+bool reinterprets(Type *from, Type *to) {
+  from = stripStaticArrays(from);
+  to = stripStaticArrays(to);
+  const char *fromName = getTBAATypeName(from);
+  const char *toName = getTBAATypeName(to);
+  if (fromName && toName) {
+    return llvm::StringRef(fromName) != toName;
+  }
+  return !from->equivalent(to);
+}
+
+bool isPointerLike(Type *t) {
+  return t->ty == Tpointer || t->ty == Tarray || t->ty == Tsarray;
+}
+
+/// Returns true if casting the pointer, slice or class reference `from` to `to`
+/// changes the type of the memory it refers to.
+bool reinterpretsPointee(Type *from, Type *to) {
+  from = from->toBasetype();
+  to = to->toBasetype();
+  if (from->ty == Tclass && to->ty == Tclass) {
+    return false;
+  }
+  if (!isPointerLike(from) || !isPointerLike(to)) {
+    return true;
+  }
+  return reinterprets(from->nextOf(), to->nextOf());
+}
+
+bool isPunnedPointer(Expression *e);
+
+bool isPunnedLValue(Expression *e) {
+  switch (e->op) {
+  case TOKcast: {
+    auto ce = static_cast<CastExp *>(e);
+    return reinterprets(ce->e1->type, ce->type) || isPunnedLValue(ce->e1);
+  }
+  case TOKstar:
+    return isPunnedPointer(static_cast<PtrExp *>(e)->e1);
+  case TOKindex: {
+    Expression *e1 = static_cast<IndexExp *>(e)->e1;
+    return e1->type->toBasetype()->ty == Tsarray ? isPunnedLValue(e1)
+                                                 : isPunnedPointer(e1);
+  }
+  case TOKdotvar: {
+    auto dve = static_cast<DotVarExp *>(e);
+    VarDeclaration *vd = dve->var->isVarDeclaration();
+    if (vd && vd->overlapped) {
+      return true;
+    }
+    return dve->e1->type->toBasetype()->ty == Tstruct
+               ? isPunnedLValue(dve->e1)
+               : isPunnedPointer(dve->e1);
+  }
+  case TOKcomma:
+    return isPunnedLValue(static_cast<CommaExp *>(e)->e2);
+  case TOKquestion: {
+    auto ce = static_cast<CondExp *>(e);
+    return isPunnedLValue(ce->e1) || isPunnedLValue(ce->e2);
+  }
+  default:
+    return false;
+  }
+}
+
+/// Returns true if the memory the pointer, slice or class reference e refers
+/// to might have been stored as a different type.
+bool isPunnedPointer(Expression *e) {
+  if (e->type->toBasetype()->ty == Tsarray) {
+    return isPunnedLValue(e);
+  }
+
+  switch (e->op) {
+  case TOKcast: {
+    auto ce = static_cast<CastExp *>(e);
+    return reinterpretsPointee(ce->e1->type, ce->type) ||
+           isPunnedPointer(ce->e1);
+  }
+  case TOKadd:
+  case TOKmin: {
+    auto be = static_cast<BinExp *>(e);
+    return isPunnedPointer(be->e1->type->toBasetype()->ty == Tpointer
+                               ? be->e1
+                               : be->e2);
+  }
+  case TOKaddress:
+    return isPunnedLValue(static_cast<AddrExp *>(e)->e1);
+  case TOKslice:
+    return isPunnedPointer(static_cast<SliceExp *>(e)->e1);
+  case TOKcomma:
+    return isPunnedPointer(static_cast<CommaExp *>(e)->e2);
+  case TOKquestion: {
+    auto ce = static_cast<CondExp *>(e);
+    return isPunnedPointer(ce->e1) || isPunnedPointer(ce->e2);
+  }
+  default:
+    return false;
+  }
+}
+} // anonymous namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool isTypePunnedLValue(Expression *e) {
+  if (!enableDTBAA || !isOptimizationEnabled()) {
+    return false;
+  }
+  return isPunnedLValue(e);
+}
+
+void addTBAAMetadata(llvm::Instruction *inst, DValue *lval) {
+  if (!enableDTBAA || !isOptimizationEnabled()) {
+    return;
+  }
+
+  DLValue *lv = lval->isLVal();
+  if (!lv || lv->typePunned) {
+    return;
+  }
+
+  if (const char *name = getTBAATypeName(lv->type)) {
+    inst->setMetadata(llvm::LLVMContext::MD_tbaa, getTBAAAccessTag(name));
+  }
+}
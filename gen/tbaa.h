@@ -0,0 +1,35 @@
+//===-- gen/tbaa.h - D type-based alias analysis metadata -------*- C++ -*-===//
+//
+//                         LDC – the LLVM D compiler
+//
+// This file is distributed under the BSD-style LDC license. See the LICENSE
+// file for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// With -enable-d-tbaa, attaches TBAA access tags derived from D types to loads
+// and stores of scalar lvalues, so that LLVM knows that e.g. a store through
+// an int* cannot modify a double.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LDC_GEN_TBAA_H
+#define LDC_GEN_TBAA_H
+
+class DValue;
+class Expression;
+namespace llvm {
+class Instruction;
+}
+
+/// Returns true if the memory designated by the lvalue expression e might have
+/// been stored as a different type, i.e. if it is an overlapping union member
+/// or is reached through a reinterpreting pointer/array cast. Such accesses
+/// must not be tagged.
+bool isTypePunnedLValue(Expression *e);
+
+/// Tags the load from or store to the given lvalue with the TBAA type of its
+/// D type (if any).
+void addTBAAMetadata(llvm::Instruction *inst, DValue *lval);
+
+#endif
@@ -9,10 +9,12 @@
 
 #include "declaration.h"
 #include "id.h"
+#include "module.h"
 #include "mtype.h"
 #include "target.h"
 #include "pragma.h"
 #include "gen/abi.h"
+#include "gen/arrays.h"
 #include "gen/classes.h"
 #include "gen/dvalue.h"
 #include "gen/funcgenstate.h"
@@ -26,8 +28,14 @@
 #include "gen/runtime.h"
 #include "ir/irfunction.h"
 #include "ir/irtype.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/LLVMContext.h"
 
+#define DEBUG_TYPE "tocall"
+
+STATISTIC(NumInvokesAvoided, "Number of invokes (and landing pad uses) "
+                             "avoided by nothrow inference at codegen time");
+
 ////////////////////////////////////////////////////////////////////////////////
 
 IrFuncTy &DtoIrTypeFunction(DValue *fnval) {
@@ -627,6 +635,20 @@ bool DtoLowerMagicIntrinsic(IRState *p, FuncDeclaration *fndecl, CallExp *e,
     return true;
   }
 
+  // The frontend lowers array ordering comparisons to `object.__cmp(a, b)`;
+  // avoid the call (and the per-element opCmp dispatch) for scalar elements.
+  if (fndecl->ident == Id::__cmp && fndecl->getModule() &&
+      fndecl->getModule()->ident == Id::object && e->arguments->dim == 2) {
+    Expression *exp1 = (*e->arguments)[0];
+    Expression *exp2 = (*e->arguments)[1];
+    if (canInlineArrayCmp(exp1->type, exp2->type)) {
+      DValue *lhs = toElem(exp1);
+      DValue *rhs = toElem(exp2);
+      result = new DImValue(e->type, DtoInlineArrayCmp(e->loc, lhs, rhs));
+      return true;
+    }
+  }
+
   return false;
 }
 
@@ -869,8 +891,18 @@ DValue *DtoCallFunctionImpl(Loc &loc, Type *resulttype, DValue *fnval,
   }
 
   // call the function
+  // For direct calls, the body of the callee may tell us that it cannot throw
+  // even if the function is not marked (or inferred) as `nothrow`.
+  bool isNothrow = tf->isnothrow;
+  if (!isNothrow && dfnval && dfnval->func &&
+      llvm::isa<llvm::Function>(callable->stripPointerCasts()) &&
+      DtoIsNothrow(dfnval->func)) {
+    isNothrow = true;
+    if (!gIR->funcGen().scopes.empty())
+      ++NumInvokesAvoided;
+  }
   LLCallSite call =
-      gIR->funcGen().callOrInvoke(callable, args, "", tf->isnothrow);
+      gIR->funcGen().callOrInvoke(callable, args, "", isNothrow);
 
 #if LDC_LLVM_VER >= 309
   // PGO: Insert instrumentation or attach profile metadata at indirect call
@@ -31,6 +31,7 @@
 #include "gen/runtime.h"
 #include "gen/scope_exit.h"
 #include "gen/structs.h"
+#include "gen/tbaa.h"
 #include "gen/tollvm.h"
 #include "gen/typinf.h"
 #include "gen/warnings.h"
@@ -907,7 +908,8 @@ public:
     // get the rvalue and return it as an lvalue
     LLValue *V = DtoRVal(e->e1);
 
-    result = new DLValue(e->type, DtoBitCast(V, DtoPtrToType(e->type)));
+    result = new DLValue(e->type, DtoBitCast(V, DtoPtrToType(e->type)),
+                         isTypePunnedLValue(e));
   }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -949,7 +951,8 @@ public:
       }
 
       // Logger::cout() << "mem: " << *arrptr << '\n';
-      result = new DLValue(e->type, DtoBitCast(arrptr, DtoPtrToType(e->type)));
+      result = new DLValue(e->type, DtoBitCast(arrptr, DtoPtrToType(e->type)),
+                           isTypePunnedLValue(e));
     } else if (FuncDeclaration *fdecl = e->var->isFuncDeclaration()) {
       DtoResolveFunction(fdecl);
 
@@ -1067,7 +1070,8 @@ public:
       IF_LOG Logger::println("e1type: %s", e1type->toChars());
       llvm_unreachable("Unknown IndexExp target.");
     }
-    result = new DLValue(e->type, DtoBitCast(arrptr, DtoPtrToType(e->type)));
+    result = new DLValue(e->type, DtoBitCast(arrptr, DtoPtrToType(e->type)),
+                         isTypePunnedLValue(e));
   }
 
   //////////////////////////////////////////////////////////////////////////////
@@ -17,6 +17,16 @@
 #include "gen/runtime.h"
 #include "gen/tollvm.h"
 #include "ir/irfunction.h"
+#include "llvm/Support/CommandLine.h"
+
+#if LDC_LLVM_VER >= 308
+static llvm::cl::opt<unsigned> cleanupCopyThreshold(
+    "cleanup-copy-threshold", llvm::cl::ZeroOrMore, llvm::cl::Hidden,
+    llvm::cl::init(32),
+    llvm::cl::desc("MSVC: Maximum number of instructions of a cleanup to be "
+                   "copied for every normal exit target; larger cleanups are "
+                   "emitted once and dispatch via a branch selector"));
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -305,13 +315,7 @@ llvm::BasicBlock *CleanupScope::run(IRState &irs, llvm::BasicBlock *sourceBlock,
   // We need a branch selector if we are here...
   if (!branchSelector) {
     // ... and have not created one yet, so do so now.
-    branchSelector = new llvm::AllocaInst(llvm::Type::getInt32Ty(irs.context()),
-#if LDC_LLVM_VER >= 500
-                                          irs.module.getDataLayout().getAllocaAddrSpace(),
-#endif
-                                          llvm::Twine("branchsel.") +
-                                              beginBlock()->getName(),
-                                          irs.topallocapoint());
+    getOrCreateBranchSelector(irs);
 
     // Now we also need to store 0 to it to keep the paths that go to the
     // only existing branch target the same.
@@ -366,7 +370,67 @@ llvm::BasicBlock *CleanupScope::run(IRState &irs, llvm::BasicBlock *sourceBlock,
   return beginBlock();
 }
 
+llvm::AllocaInst *CleanupScope::getOrCreateBranchSelector(IRState &irs) {
+  if (!branchSelector) {
+    branchSelector = new llvm::AllocaInst(llvm::Type::getInt32Ty(irs.context()),
+#if LDC_LLVM_VER >= 500
+                                          irs.module.getDataLayout().getAllocaAddrSpace(),
+#endif
+                                          llvm::Twine("branchsel.") +
+                                              beginBlock()->getName(),
+                                          irs.topallocapoint());
+  }
+  return branchSelector;
+}
+
 #if LDC_LLVM_VER >= 308
+namespace {
+// Stores the selector value in the source block, in front of the branch to the
+// cleanup if that has already been emitted.
+void storeBranchSelector(llvm::ConstantInt *value, llvm::AllocaInst *selector,
+                         llvm::BasicBlock *sourceBlock) {
+  if (auto term = sourceBlock->getTerminator()) {
+    new llvm::StoreInst(value, selector, term);
+  } else {
+    new llvm::StoreInst(value, selector, sourceBlock);
+  }
+}
+}
+
+bool CleanupScope::isCheapToCopy() const {
+  size_t numInstructions = 0;
+  for (auto bb : blocks) {
+    numInstructions += bb->size();
+    if (numInstructions > cleanupCopyThreshold)
+      return false;
+  }
+  return true;
+}
+
+void CleanupScope::runDispatching(IRState &irs, llvm::BasicBlock *sourceBlock,
+                                  unsigned targetIndex) {
+  CleanupExitTarget &target = exitTargets[targetIndex];
+  llvm::ConstantInt *const selectorVal = DtoConstUint(targetIndex);
+
+  if (dispatchBlocks.empty()) {
+    // Emit the shared copy, branching to a switch on the selector at its end.
+    auto dispatchBB = llvm::BasicBlock::Create(
+        irs.context(), "cleanup.dispatch", irs.topfunc());
+    cloneBlocks(blocks, dispatchBlocks, dispatchBB, nullptr, nullptr);
+    llvm::Value *sel =
+        new llvm::LoadInst(getOrCreateBranchSelector(irs), "", dispatchBB);
+    dispatchSwitch = llvm::SwitchInst::Create(
+        sel, target.branchTarget,
+        1, // Expected number of branches, only for pre-allocating.
+        dispatchBB);
+  } else {
+    dispatchSwitch->addCase(selectorVal, target.branchTarget);
+  }
+  target.cleanupBlocks = dispatchBlocks;
+
+  storeBranchSelector(selectorVal, branchSelector, sourceBlock);
+}
+
 llvm::BasicBlock *CleanupScope::runCopying(IRState &irs,
                                            llvm::BasicBlock *sourceBlock,
                                            llvm::BasicBlock *continueWith,
@@ -380,11 +444,17 @@ llvm::BasicBlock *CleanupScope::runCopying(IRState &irs,
       llvm::BranchInst::Create(continueWith, endBlock());
   } else {
     // check whether we have an exit target with the same continuation
-    for (CleanupExitTarget &tgt : exitTargets)
+    for (unsigned i = 0; i < exitTargets.size(); ++i) {
+      CleanupExitTarget &tgt = exitTargets[i];
       if (tgt.branchTarget == continueWith) {
         tgt.sourceBlocks.push_back(sourceBlock);
+        if (!dispatchBlocks.empty() &&
+            tgt.cleanupBlocks.front() == dispatchBlocks.front()) {
+          storeBranchSelector(DtoConstUint(i), branchSelector, sourceBlock);
+        }
         return tgt.cleanupBlocks.front();
       }
+    }
   }
 
   // reuse the original IR if not unwinding and not already used
@@ -397,6 +467,7 @@ llvm::BasicBlock *CleanupScope::runCopying(IRState &irs,
   }
 
   // append new target
+  const unsigned targetIndex = exitTargets.size();
   exitTargets.emplace_back(continueWith);
   auto &exitTarget = exitTargets.back();
   exitTarget.sourceBlocks.push_back(sourceBlock);
@@ -410,6 +481,9 @@ llvm::BasicBlock *CleanupScope::runCopying(IRState &irs,
           if (succ != continueWith)
             remapBlocksValue(blocks, succ, continueWith);
     exitTarget.cleanupBlocks = blocks;
+  } else if (unwindTo == nullptr && funclet == nullptr && !isCheapToCopy()) {
+    // share a single copy between all other normal exits
+    runDispatching(irs, sourceBlock, targetIndex);
   } else {
     // clone the code
     cloneBlocks(blocks, exitTarget.cleanupBlocks, continueWith, unwindTo,
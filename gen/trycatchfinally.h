@@ -23,6 +23,7 @@ class AllocaInst;
 class BasicBlock;
 class GlobalVariable;
 class MDNode;
+class SwitchInst;
 class Value;
 }
 
@@ -103,6 +104,10 @@ public:
   /// This means that we cannot use a branch selector and conditional branches
   /// at cleanup exit to continue with different targets.
   /// Instead we make a full copy of the cleanup code for every target.
+  ///
+  /// Normal (non-unwinding) exits of cleanups larger than
+  /// `-cleanup-copy-threshold` instructions share a single copy instead, which
+  /// dispatches to the exit target via a branch selector.
   llvm::BasicBlock *runCopying(IRState &irs, llvm::BasicBlock *sourceBlock,
                                llvm::BasicBlock *continueWith,
                                llvm::BasicBlock *unwindTo = nullptr,
@@ -117,6 +122,24 @@ private:
   /// The branch selector variable, or null if not created yet.
   llvm::AllocaInst *branchSelector = nullptr;
 
+  /// MSVC: The copy of the cleanup code shared by all normal exits that
+  /// dispatch via the branch selector, or empty if not created yet.
+  std::vector<llvm::BasicBlock *> dispatchBlocks;
+
+  /// MSVC: The switch on the branch selector terminating `dispatchBlocks`.
+  llvm::SwitchInst *dispatchSwitch = nullptr;
+
+  llvm::AllocaInst *getOrCreateBranchSelector(IRState &irs);
+
+  /// MSVC: Returns whether copying the cleanup code for another exit target is
+  /// considered cheaper than dispatching via the branch selector.
+  bool isCheapToCopy() const;
+
+  /// MSVC: Sets up the exit target with the given index to branch to the
+  /// shared dispatching copy of the cleanup code.
+  void runDispatching(IRState &irs, llvm::BasicBlock *sourceBlock,
+                      unsigned targetIndex);
+
   /// Describes a particular way to leave a cleanup scope and continue execution
   /// with another one.
   ///
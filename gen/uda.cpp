@@ -1,7 +1,9 @@
 #include "gen/uda.h"
 
+#include "gen/irstate.h"
 #include "gen/llvm.h"
 #include "gen/llvmhelpers.h"
+#include "gen/logger.h"
 #include "aggregate.h"
 #include "attrib.h"
 #include "declaration.h"
@@ -11,6 +13,9 @@
 #include "id.h"
 
 #include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 
 namespace {
 
@@ -272,16 +277,7 @@ void applyAttrSection(StructLiteralExp *sle, llvm::GlobalObject *globj) {
   globj->setSection(getFirstElemString(sle));
 }
 
-void applyAttrTarget(StructLiteralExp *sle, llvm::Function *func) {
-  // TODO: this is a rudimentary implementation for @target. Many more
-  // target-related attributes could be applied to functions (not just for
-  // @target): clang applies many attributes that LDC does not.
-  // The current implementation here does not do any checking of the specified
-  // string and simply passes all to llvm.
-
-  checkStructElems(sle, {Type::tstring});
-  std::string targetspec = getFirstElemString(sle);
-
+void applyTargetSpec(llvm::StringRef targetspec, llvm::Function *func) {
   if (targetspec.empty() || targetspec == "default")
     return;
 
@@ -337,6 +333,224 @@ void applyAttrTarget(StructLiteralExp *sle, llvm::Function *func) {
   }
 }
 
+void applyAttrTarget(StructLiteralExp *sle, llvm::Function *func) {
+  // TODO: this is a rudimentary implementation for @target. Many more
+  // target-related attributes could be applied to functions (not just for
+  // @target): clang applies many attributes that LDC does not.
+  // The current implementation here does not do any checking of the specified
+  // string and simply passes all to llvm.
+
+  checkStructElems(sle, {Type::tstring});
+  applyTargetSpec(getFirstElemString(sle), func);
+}
+
+StructLiteralExp *getTargetClonesAttr(FuncDeclaration *decl) {
+  if (!decl->userAttribDecl)
+    return nullptr;
+
+  Expressions *attrs = decl->userAttribDecl->getAttributes();
+  expandTuples(attrs);
+  for (auto &attr : *attrs) {
+    auto sle = getLdcAttributesStruct(attr);
+    if (sle && sle->sd->ident == Id::udaTargetClones)
+      return sle;
+  }
+  return nullptr;
+}
+
+/// Returns the strings of the string[] element `idx`.
+std::vector<llvm::StringRef> getStringArrayElem(StructLiteralExp *sle,
+                                                size_t idx) {
+  std::vector<llvm::StringRef> result;
+  auto arg = (*sle->elements)[idx];
+  if (arg && arg->op == TOKarrayliteral) {
+    auto ale = static_cast<ArrayLiteralExp *>(arg);
+    for (size_t i = 0; i < ale->elements->dim; ++i) {
+      auto e = ale->getElement(i);
+      if (e->op == TOKstring) {
+        auto strexp = static_cast<StringExp *>(e);
+        assert(strexp->sz == 1);
+        result.push_back(strexp->toStringz());
+      }
+    }
+  }
+  return result;
+}
+
+/// The bit indices of the CPU features in libgcc's/compiler-rt's
+/// __cpu_model.__cpu_features[0], as set by __cpu_indicator_init().
+int getCPUFeatureBit(llvm::StringRef feature) {
+  return llvm::StringSwitch<int>(feature)
+      .Case("cmov", 0)
+      .Case("mmx", 1)
+      .Case("popcnt", 2)
+      .Case("sse", 3)
+      .Case("sse2", 4)
+      .Case("sse3", 5)
+      .Case("ssse3", 6)
+      .Case("sse4.1", 7)
+      .Case("sse4.2", 8)
+      .Case("avx", 9)
+      .Case("avx2", 10)
+      .Case("sse4a", 11)
+      .Case("fma4", 12)
+      .Case("xop", 13)
+      .Case("fma", 14)
+      .Case("avx512f", 15)
+      .Case("bmi", 16)
+      .Case("bmi2", 17)
+      .Case("aes", 18)
+      .Case("pclmul", 19)
+      .Case("avx512vl", 20)
+      .Case("avx512bw", 21)
+      .Case("avx512dq", 22)
+      .Case("avx512cd", 23)
+      .Case("avx512er", 24)
+      .Case("avx512pf", 25)
+      .Case("avx512vbmi", 26)
+      .Case("avx512ifma", 27)
+      .Default(-1);
+}
+
+#if LDC_LLVM_VER >= 400
+/// Replaces the definition of `func` by an ifunc, which selects one of
+/// several clones of it compiled for different target features at load time.
+///
+///   @func = ifunc @func.resolver
+///   define internal @func.default()  ; the original definition
+///   define internal @func.<feature>() #<+feature>
+///   define internal @func.resolver() {
+///     call @__cpu_indicator_init()
+///     ; returns the first clone supported by the CPU, in the order of the
+///     ; UDA arguments, or @func.default
+///   }
+void emitTargetClones(IRState &irs, llvm::Function *func,
+                      llvm::ArrayRef<std::pair<int, llvm::StringRef>> clones) {
+  auto &ctx = irs.context();
+  const std::string name = func->getName();
+  const auto linkage = func->getLinkage();
+  const auto visibility = func->getVisibility();
+
+  // The implementations are only referenced by the resolver.
+  func->setName(name + ".default");
+  func->setLinkage(llvm::GlobalValue::InternalLinkage);
+  func->setVisibility(llvm::GlobalValue::DefaultVisibility);
+  func->setComdat(nullptr);
+
+  auto resolverType = llvm::FunctionType::get(func->getType(), false);
+  auto resolver =
+      llvm::Function::Create(resolverType, llvm::GlobalValue::InternalLinkage,
+                             name + ".resolver", &irs.module);
+  resolver->addFnAttr(llvm::Attribute::NoUnwind);
+
+  auto ifunc = llvm::GlobalIFunc::create(func->getFunctionType(), 0, linkage,
+                                         name, resolver, &irs.module);
+  ifunc->setVisibility(visibility);
+  // Direct calls (also recursive ones) are dispatched too.
+  func->replaceAllUsesWith(ifunc);
+
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "", resolver));
+  builder.CreateCall(irs.module.getOrInsertFunction(
+      "__cpu_indicator_init", llvm::FunctionType::get(builder.getVoidTy(),
+                                                      false)));
+
+  // struct __processor_model {
+  //   unsigned int __cpu_vendor, __cpu_type, __cpu_subtype;
+  //   unsigned int __cpu_features[1];
+  // } __cpu_model;
+  auto i32 = builder.getInt32Ty();
+  auto cpuModelType = llvm::StructType::get(
+      ctx, {i32, i32, i32, llvm::ArrayType::get(i32, 1)});
+  auto cpuModel = irs.module.getOrInsertGlobal("__cpu_model", cpuModelType);
+  llvm::Value *indices[] = {builder.getInt32(0), builder.getInt32(3),
+                            builder.getInt32(0)};
+  auto features =
+      builder.CreateLoad(builder.CreateInBoundsGEP(cpuModelType, cpuModel,
+                                                   indices),
+                         "cpu_features");
+
+  for (const auto &c : clones) {
+    llvm::ValueToValueMapTy vmap;
+    auto clone = llvm::CloneFunction(func, vmap);
+    clone->setName(name + "." + c.second);
+    applyTargetSpec(c.second, clone);
+
+    auto mask = builder.getInt32(1u << c.first);
+    auto supported =
+        builder.CreateICmpEQ(builder.CreateAnd(features, mask), mask);
+    auto thenBB = llvm::BasicBlock::Create(ctx, c.second, resolver);
+    auto elseBB = llvm::BasicBlock::Create(ctx, "", resolver);
+    builder.CreateCondBr(supported, thenBB, elseBB);
+    builder.SetInsertPoint(thenBB);
+    builder.CreateRet(clone);
+    builder.SetInsertPoint(elseBB);
+  }
+  builder.CreateRet(func);
+}
+
+bool isTargetClonesSupported() {
+  const auto &triple = *global.params.targetTriple;
+  return triple.isOSBinFormatELF() &&
+         (triple.getArch() == llvm::Triple::x86 ||
+          triple.getArch() == llvm::Triple::x86_64);
+}
+
+/// Collects the CPU feature bits and names of the clones to emit for a valid
+/// @targetClones UDA. Returns false if the UDA is invalid or unsupported for
+/// the target (see applyAttrTargetClones()).
+bool getTargetClones(StructLiteralExp *sle,
+                     std::vector<std::pair<int, llvm::StringRef>> &clones) {
+  if (sle->elements->dim != 1 || !isTargetClonesSupported())
+    return false;
+
+  bool hasDefault = false;
+  for (auto spec : getStringArrayElem(sle, 0)) {
+    if (spec == "default") {
+      hasDefault = true;
+      continue;
+    }
+    const int bit = getCPUFeatureBit(spec);
+    if (bit < 0)
+      return false;
+    clones.emplace_back(bit, spec);
+  }
+  return hasDefault;
+}
+
+#endif
+
+/// Checks the @targetClones UDA of a function; the clones are only emitted
+/// once the module is finalized (applyTargetClonesUDAs()).
+void applyAttrTargetClones(StructLiteralExp *sle) {
+  checkStructElems(sle, {Type::tstring->arrayOf()});
+
+  bool hasDefault = false;
+  for (auto spec : getStringArrayElem(sle, 0)) {
+    if (spec == "default") {
+      hasDefault = true;
+    } else if (getCPUFeatureBit(spec) < 0) {
+      sle->error("unrecognized CPU feature `%s` for "
+                 "`@ldc.attributes.targetClones`",
+                 spec.data());
+    }
+  }
+  if (!hasDefault) {
+    sle->error("`@ldc.attributes.targetClones` requires a `\"default\"` "
+               "target");
+    return;
+  }
+
+#if LDC_LLVM_VER >= 400
+  if (!isTargetClonesSupported()) {
+    sle->warning("ignoring `@ldc.attributes.targetClones`, only supported "
+                 "for x86 ELF targets");
+  }
+#else
+  sle->warning("ignoring `@ldc.attributes.targetClones`: LDC needs to be "
+               "built against LLVM 4.0+ for support");
+#endif
+}
+
 } // anonymous namespace
 
 void applyVarDeclUDAs(VarDeclaration *decl, llvm::GlobalVariable *gvar) {
@@ -353,7 +567,8 @@ void applyVarDeclUDAs(VarDeclaration *decl, llvm::GlobalVariable *gvar) {
     auto ident = sle->sd->ident;
     if (ident == Id::udaSection) {
       applyAttrSection(sle, gvar);
-    } else if (ident == Id::udaOptStrategy || ident == Id::udaTarget) {
+    } else if (ident == Id::udaOptStrategy || ident == Id::udaTarget ||
+               ident == Id::udaTargetClones) {
       sle->error(
           "Special attribute `ldc.attributes.%s` is only valid for functions",
           ident->toChars());
@@ -394,6 +609,8 @@ void applyFuncDeclUDAs(FuncDeclaration *decl, IrFunction *irFunc) {
       applyAttrSection(sle, func);
     } else if (ident == Id::udaTarget) {
       applyAttrTarget(sle, func);
+    } else if (ident == Id::udaTargetClones) {
+      applyAttrTargetClones(sle);
     } else if (ident == Id::udaWeak || ident == Id::udaKernel) {
       // @weak and @kernel are applied elsewhere
     } else {
@@ -448,3 +665,29 @@ bool hasKernelAttr(Dsymbol *sym) {
   return true;
 }
 
+/// Checks whether 'decl' has the @ldc.attributes.targetClones UDA applied.
+bool hasTargetClonesUDA(FuncDeclaration *decl) {
+  return getTargetClonesAttr(decl) != nullptr;
+}
+
+/// Emits the clones of the functions defined in the module with the
+/// @ldc.attributes.targetClones UDA applied, and dispatches calls to the
+/// original functions via ifuncs. The UDAs have been checked by
+/// applyFuncDeclUDAs() already.
+void applyTargetClonesUDAs(IRState &irs) {
+#if LDC_LLVM_VER >= 400
+  for (auto decl : irs.targetClonedFunctions) {
+    auto sle = getTargetClonesAttr(decl);
+    assert(sle);
+    std::vector<std::pair<int, llvm::StringRef>> clones;
+    if (!getTargetClones(sle, clones) || clones.empty())
+      continue;
+
+    IF_LOG Logger::println("Emitting target clones of %s",
+                           decl->toPrettyChars());
+    LOG_SCOPE
+    emitTargetClones(irs, DtoFunction(decl), clones);
+  }
+#endif
+  irs.targetClonedFunctions.clear();
+}
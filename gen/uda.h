@@ -18,6 +18,7 @@
 class Dsymbol;
 class FuncDeclaration;
 class VarDeclaration;
+struct IRState;
 struct IrFunction;
 namespace llvm {
 class GlobalVariable;
@@ -27,6 +28,8 @@ void applyFuncDeclUDAs(FuncDeclaration *decl, IrFunction *irFunc);
 void applyVarDeclUDAs(VarDeclaration *decl, llvm::GlobalVariable *gvar);
 
 bool hasWeakUDA(Dsymbol *sym);
+bool hasTargetClonesUDA(FuncDeclaration *decl);
+void applyTargetClonesUDAs(IRState &irs);
 bool hasKernelAttr(Dsymbol *sym);
 /// Must match ldc.dcompute.Compilefor + 1 == DComputeCompileFor
 enum class DComputeCompileFor : int
@@ -65,6 +65,10 @@ struct IrFunction {
   int depth = -1;
   bool nestedContextCreated = false; // holds whether nested context is created
 
+  // whether the function body has been inferred not to throw at codegen time
+  // (-1 if not inferred yet)
+  int inferredNothrow = -1;
+
   // TODO: Move to FuncGenState?
   llvm::Value *_arguments = nullptr;
   llvm::Value *_argptr = nullptr;
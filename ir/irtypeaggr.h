@@ -12,7 +12,6 @@
 
 #include "ir/irtype.h"
 #include "llvm/ADT/ArrayRef.h"
-#include "llvm/IR/DebugInfo.h"
 #include <map>
 #include <vector>
 
@@ -67,10 +66,6 @@ public:
   void getMemberLocation(VarDeclaration *var, unsigned &fieldIndex,
                          unsigned &byteOffset) const;
 
-  /// Composite type debug description. This is not only to cache, but also
-  /// used for resolving forward references.
-  llvm::DIType *diCompositeType = nullptr;
-
   /// true, if the LLVM struct type for the aggregate is declared as packed
   bool packed = false;
 
@@ -29,6 +29,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 
@@ -117,9 +118,90 @@ struct WeightedFile {
 };
 typedef SmallVector<WeightedFile, 5> WeightedFileVector;
 
+/// An input read by a worker thread, waiting to be merged.
+struct LoadedInput {
+  std::unique_ptr<InstrProfReader> Reader;
+  std::vector<InstrProfRecord> Records;
+  Error Err = Error::success();
+
+  /// Free the records and the reader once the input is merged.
+  void release() {
+    Reader.reset();
+    decltype(Records)().swap(Records);
+  }
+};
+
+/// Read all records of an input. This is the expensive part of merging and is
+/// done in parallel; the records refer to the reader, which is kept alive.
+static void readInput(const WeightedFile &Input, LoadedInput *LI) {
+  auto ReaderOrErr = InstrProfReader::create(Input.Filename);
+  if (Error E = ReaderOrErr.takeError()) {
+    consumeError(std::move(LI->Err));
+    LI->Err = std::move(E);
+    return;
+  }
+
+  LI->Reader = std::move(ReaderOrErr.get());
+  for (auto &I : *LI->Reader)
+    LI->Records.push_back(std::move(I));
+}
+
+/// Keep track of merged data and reported errors.
+struct WriterContext {
+  InstrProfWriter Writer;
+  Error Err;
+  StringRef ErrWhence;
+  SmallSet<instrprof_error, 4> WriterErrorCodes;
+
+  WriterContext(bool IsSparse)
+      : Writer(IsSparse), Err(Error::success()), ErrWhence("") {}
+};
+
+/// Merge a read input into the writer context. The inputs are merged one by
+/// one in the order given on the command line, so that the output does not
+/// depend on the number of threads used for reading. Hard errors are deferred
+/// until the worker threads are done.
+static void mergeInput(const WeightedFile &Input, LoadedInput &LI,
+                       WriterContext *WC) {
+  // If there's a pending hard error, don't do more work.
+  if (WC->Err) {
+    consumeError(std::move(LI.Err));
+    return;
+  }
+
+  WC->ErrWhence = Input.Filename;
+
+  if (LI.Err) {
+    WC->Err = std::move(LI.Err);
+    return;
+  }
+
+  bool IsIRProfile = LI.Reader->isIRLevelProfile();
+  if (WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
+    WC->ErrWhence = "";
+    WC->Err = make_error<StringError>(
+        "Merge IR generated profile with Clang generated profile.",
+        std::error_code());
+    return;
+  }
+
+  for (auto &I : LI.Records) {
+    if (Error E = WC->Writer.addRecord(std::move(I), Input.Weight)) {
+      // Only show hint the first time an error occurs.
+      instrprof_error IPE = InstrProfError::take(std::move(E));
+      bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
+      handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
+                             I.Name, firstTime);
+    }
+  }
+  if (LI.Reader->hasError())
+    WC->Err = LI.Reader->getError();
+}
+
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
                               StringRef OutputFilename,
-                              ProfileFormat OutputFormat, bool OutputSparse) {
+                              ProfileFormat OutputFormat, bool OutputSparse,
+                              unsigned NumThreads) {
   if (OutputFilename.compare("-") == 0)
     exitWithError("Cannot write indexed profdata format to stdout.");
 
@@ -131,30 +213,44 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   if (EC)
     exitWithErrorCode(EC, OutputFilename);
 
-  InstrProfWriter Writer(OutputSparse);
-  SmallSet<instrprof_error, 4> WriterErrorCodes;
-  for (const auto &Input : Inputs) {
-    auto ReaderOrErr = InstrProfReader::create(Input.Filename);
-    if (Error E = ReaderOrErr.takeError())
-      exitWithError(std::move(E), Input.Filename);
-
-    auto Reader = std::move(ReaderOrErr.get());
-    bool IsIRProfile = Reader->isIRLevelProfile();
-    if (Writer.setIsIRLevelProfile(IsIRProfile))
-      exitWithError("Merge IR generated profile with Clang generated profile.");
-
-    for (auto &I : *Reader) {
-      if (Error E = Writer.addRecord(std::move(I), Input.Weight)) {
-        // Only show hint the first time an error occurs.
-        instrprof_error IPE = InstrProfError::take(std::move(E));
-        bool firstTime = WriterErrorCodes.insert(IPE).second;
-        handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
-                               I.Name, firstTime);
-      }
+  // If NumThreads is not specified, auto-detect a good default.
+  if (NumThreads == 0)
+    NumThreads = std::max(1U, std::min(std::thread::hardware_concurrency(),
+                                       unsigned(Inputs.size() / 2)));
+
+  WriterContext WC(OutputSparse);
+  std::vector<LoadedInput> Loaded(Inputs.size());
+
+  if (NumThreads == 1) {
+    for (size_t I = 0, E = Inputs.size(); I < E; ++I) {
+      readInput(Inputs[I], &Loaded[I]);
+      mergeInput(Inputs[I], Loaded[I], &WC);
+      Loaded[I].release();
+    }
+  } else {
+    ThreadPool Pool(NumThreads);
+
+    // Read the inputs in parallel, a bounded number of inputs ahead of the
+    // (serial) merging, which frees the records of the merged inputs.
+    const size_t Window = 4 * NumThreads;
+    std::vector<std::shared_future<void>> Pending(Inputs.size());
+    for (size_t I = 0, E = std::min(Window, Inputs.size()); I < E; ++I)
+      Pending[I] = Pool.async(readInput, Inputs[I], &Loaded[I]);
+    for (size_t I = 0, E = Inputs.size(); I < E; ++I) {
+      Pending[I].wait();
+      if (I + Window < E)
+        Pending[I + Window] =
+            Pool.async(readInput, Inputs[I + Window], &Loaded[I + Window]);
+      mergeInput(Inputs[I], Loaded[I], &WC);
+      Loaded[I].release();
     }
-    if (Reader->hasError())
-      exitWithError(Reader->getError(), Input.Filename);
   }
+
+  // Handle deferred hard errors encountered during merging.
+  if (WC.Err)
+    exitWithError(std::move(WC.Err), WC.ErrWhence);
+
+  InstrProfWriter &Writer = WC.Writer;
   if (OutputFormat == PF_Text)
     Writer.writeText(Output);
   else
@@ -288,6 +384,11 @@ static int merge_main(int argc, const char *argv[]) {
                  clEnumValEnd));
   cl::opt<bool> OutputSparse("sparse", cl::init(false),
       cl::desc("Generate a sparse profile (only meaningful for -instr)"));
+  cl::opt<unsigned> NumThreads(
+      "num-threads", cl::init(0),
+      cl::desc("Number of merge threads to use (default: autodetect)"));
+  cl::alias NumThreadsA("j", cl::desc("Alias for --num-threads"),
+                        cl::aliasopt(NumThreads));
 
   cl::ParseCommandLineOptions(argc, argv, "LLVM profile data merger\n");
 
@@ -314,7 +415,7 @@ static int merge_main(int argc, const char *argv[]) {
 
   if (ProfileKind == instr)
     mergeInstrProfile(WeightedInputs, OutputFilename, OutputFormat,
-                      OutputSparse);
+                      OutputSparse, NumThreads);
   else
     mergeSampleProfile(WeightedInputs, OutputFilename, OutputFormat);
 
@@ -114,42 +114,67 @@ struct WeightedFile {
 };
 typedef SmallVector<WeightedFile, 5> WeightedFileVector;
 
+/// An input read by a worker thread, waiting to be merged.
+struct LoadedInput {
+  std::unique_ptr<InstrProfReader> Reader;
+  std::vector<InstrProfRecord> Records;
+  Error Err = Error::success();
+
+  /// Free the records and the reader once the input is merged.
+  void release() {
+    Reader.reset();
+    decltype(Records)().swap(Records);
+  }
+};
+
+/// Read all records of an input. This is the expensive part of merging and is
+/// done in parallel; the records refer to the reader, which is kept alive.
+static void readInput(const WeightedFile &Input, LoadedInput *LI) {
+  auto ReaderOrErr = InstrProfReader::create(Input.Filename);
+  if (Error E = ReaderOrErr.takeError()) {
+    consumeError(std::move(LI->Err));
+    LI->Err = std::move(E);
+    return;
+  }
+
+  LI->Reader = std::move(ReaderOrErr.get());
+  for (auto &I : *LI->Reader)
+    LI->Records.push_back(std::move(I));
+}
+
 /// Keep track of merged data and reported errors.
 struct WriterContext {
-  std::mutex Lock;
   InstrProfWriter Writer;
   Error Err;
   StringRef ErrWhence;
-  std::mutex &ErrLock;
-  SmallSet<instrprof_error, 4> &WriterErrorCodes;
+  SmallSet<instrprof_error, 4> WriterErrorCodes;
 
-  WriterContext(bool IsSparse, std::mutex &ErrLock,
-                SmallSet<instrprof_error, 4> &WriterErrorCodes)
-      : Lock(), Writer(IsSparse), Err(Error::success()), ErrWhence(""),
-        ErrLock(ErrLock), WriterErrorCodes(WriterErrorCodes) {}
+  WriterContext(bool IsSparse)
+      : Writer(IsSparse), Err(Error::success()), ErrWhence("") {}
 };
 
-/// Load an input into a writer context.
-static void loadInput(const WeightedFile &Input, WriterContext *WC) {
-  std::unique_lock<std::mutex> CtxGuard{WC->Lock};
-
+/// Merge a read input into the writer context. The inputs are merged one by
+/// one in the order given on the command line, so that the output does not
+/// depend on the number of threads used for reading.
+static void mergeInput(const WeightedFile &Input, LoadedInput &LI,
+                       WriterContext *WC) {
   // If there's a pending hard error, don't do more work.
-  if (WC->Err)
+  if (WC->Err) {
+    consumeError(std::move(LI.Err));
     return;
+  }
 
   WC->ErrWhence = Input.Filename;
 
-  auto ReaderOrErr = InstrProfReader::create(Input.Filename);
-  if (Error E = ReaderOrErr.takeError()) {
+  if (LI.Err) {
     // Skip the empty profiles by returning sliently.
-    instrprof_error IPE = InstrProfError::take(std::move(E));
+    instrprof_error IPE = InstrProfError::take(std::move(LI.Err));
     if (IPE != instrprof_error::empty_raw_profile)
       WC->Err = make_error<InstrProfError>(IPE);
     return;
   }
 
-  auto Reader = std::move(ReaderOrErr.get());
-  bool IsIRProfile = Reader->isIRLevelProfile();
+  bool IsIRProfile = LI.Reader->isIRLevelProfile();
   if (WC->Writer.setIsIRLevelProfile(IsIRProfile)) {
     WC->Err = make_error<StringError>(
         "Merge IR generated profile with Clang generated profile.",
@@ -157,25 +182,18 @@ static void loadInput(const WeightedFile &Input, WriterContext *WC) {
     return;
   }
 
-  for (auto &I : *Reader) {
+  for (auto &I : LI.Records) {
     const StringRef FuncName = I.Name;
     if (Error E = WC->Writer.addRecord(std::move(I), Input.Weight)) {
       // Only show hint the first time an error occurs.
       instrprof_error IPE = InstrProfError::take(std::move(E));
-      std::unique_lock<std::mutex> ErrGuard{WC->ErrLock};
       bool firstTime = WC->WriterErrorCodes.insert(IPE).second;
       handleMergeWriterError(make_error<InstrProfError>(IPE), Input.Filename,
                              FuncName, firstTime);
     }
   }
-  if (Reader->hasError())
-    WC->Err = Reader->getError();
-}
-
-/// Merge the \p Src writer context into \p Dst.
-static void mergeWriterContexts(WriterContext *Dst, WriterContext *Src) {
-  if (Error E = Dst->Writer.mergeRecordsFromWriter(std::move(Src->Writer)))
-    Dst->Err = std::move(E);
+  if (LI.Reader->hasError())
+    WC->Err = LI.Reader->getError();
 }
 
 static void mergeInstrProfile(const WeightedFileVector &Inputs,
@@ -193,59 +211,44 @@ static void mergeInstrProfile(const WeightedFileVector &Inputs,
   if (EC)
     exitWithErrorCode(EC, OutputFilename);
 
-  std::mutex ErrorLock;
-  SmallSet<instrprof_error, 4> WriterErrorCodes;
-
   // If NumThreads is not specified, auto-detect a good default.
   if (NumThreads == 0)
     NumThreads = std::max(1U, std::min(std::thread::hardware_concurrency(),
                                        unsigned(Inputs.size() / 2)));
 
-  // Initialize the writer contexts.
-  SmallVector<std::unique_ptr<WriterContext>, 4> Contexts;
-  for (unsigned I = 0; I < NumThreads; ++I)
-    Contexts.emplace_back(llvm::make_unique<WriterContext>(
-        OutputSparse, ErrorLock, WriterErrorCodes));
+  WriterContext WC(OutputSparse);
+  std::vector<LoadedInput> Loaded(Inputs.size());
 
   if (NumThreads == 1) {
-    for (const auto &Input : Inputs)
-      loadInput(Input, Contexts[0].get());
+    for (size_t I = 0, E = Inputs.size(); I < E; ++I) {
+      readInput(Inputs[I], &Loaded[I]);
+      mergeInput(Inputs[I], Loaded[I], &WC);
+      Loaded[I].release();
+    }
   } else {
     ThreadPool Pool(NumThreads);
 
-    // Load the inputs in parallel (N/NumThreads serial steps).
-    unsigned Ctx = 0;
-    for (const auto &Input : Inputs) {
-      Pool.async(loadInput, Input, Contexts[Ctx].get());
-      Ctx = (Ctx + 1) % NumThreads;
+    // Read the inputs in parallel, a bounded number of inputs ahead of the
+    // (serial) merging, which frees the records of the merged inputs.
+    const size_t Window = 4 * NumThreads;
+    std::vector<std::shared_future<void>> Pending(Inputs.size());
+    for (size_t I = 0, E = std::min(Window, Inputs.size()); I < E; ++I)
+      Pending[I] = Pool.async(readInput, Inputs[I], &Loaded[I]);
+    for (size_t I = 0, E = Inputs.size(); I < E; ++I) {
+      Pending[I].wait();
+      if (I + Window < E)
+        Pending[I + Window] =
+            Pool.async(readInput, Inputs[I + Window], &Loaded[I + Window]);
+      mergeInput(Inputs[I], Loaded[I], &WC);
+      Loaded[I].release();
     }
-    Pool.wait();
-
-    // Merge the writer contexts together (~ lg(NumThreads) serial steps).
-    unsigned Mid = Contexts.size() / 2;
-    unsigned End = Contexts.size();
-    assert(Mid > 0 && "Expected more than one context");
-    do {
-      for (unsigned I = 0; I < Mid; ++I)
-        Pool.async(mergeWriterContexts, Contexts[I].get(),
-                   Contexts[I + Mid].get());
-      Pool.wait();
-      if (End & 1) {
-        Pool.async(mergeWriterContexts, Contexts[0].get(),
-                   Contexts[End - 1].get());
-        Pool.wait();
-      }
-      End = Mid;
-      Mid /= 2;
-    } while (Mid > 0);
   }
 
   // Handle deferred hard errors encountered during merging.
-  for (std::unique_ptr<WriterContext> &WC : Contexts)
-    if (WC->Err)
-      exitWithError(std::move(WC->Err), WC->ErrWhence);
+  if (WC.Err)
+    exitWithError(std::move(WC.Err), WC.ErrWhence);
 
-  InstrProfWriter &Writer = Contexts[0]->Writer;
+  InstrProfWriter &Writer = WC.Writer;
   if (OutputFormat == PF_Text)
     Writer.writeText(Output);
   else